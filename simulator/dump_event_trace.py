@@ -0,0 +1,41 @@
+import struct
+import sys
+
+# Print the binary event trace written by simedc (see libc/event_trace.hpp).
+RECORD_TYPES = {
+    0: "iteration begin",
+    1: "disk failure",
+    2: "disk repair",
+    3: "disk replacement",
+    4: "chunk repair",
+    5: "data loss",
+    6: "iteration end",
+}
+
+
+def dump(fname):
+    with open(fname, "rb") as f:
+        magic = f.read(8)
+        if magic != b"SIMEDCEV":
+            print("Not an event trace file: " + fname)
+            return
+        version, record_size = struct.unpack("<II", f.read(8))
+        print("# version = %d, record size = %d" % (version, record_size))
+        print("event_time,event_type,element_id,repair_bwth")
+        while True:
+            record = f.read(record_size)
+            if len(record) < record_size:
+                break
+            event_time, repair_bwth, element_id, event_type = struct.unpack(
+                "<ddii", record[:24])
+            print("%.6f,%s,%d,%.6f" % (event_time,
+                                       RECORD_TYPES.get(event_type, str(event_type)),
+                                       element_id, repair_bwth))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("Usage: python dump_event_trace.py [event trace file]")
+        sys.exit(0)
+    for fname in sys.argv[1:]:
+        dump(fname)
@@ -0,0 +1,122 @@
+#include "analytic.hpp"
+
+AnalyticModel::AnalyticModel(const Configure &configure)
+  :code_type_(configure.code_type), code_n_(configure.code_n),
+   code_k_(configure.code_k), code_l_(configure.code_l),
+   lazy_repair_(configure.lazy_repair),
+   lazy_repair_threshold_(configure.lazy_repair_threshold),
+   failure_rate_(1.0 / configure.disk_fail_dists.b()),
+   mission_time_(configure.mission_time), num_stripes_(configure.num_stripes),
+   chunk_size_(configure.chunk_size),
+   repair_bwth_(configure.network_setting[0]) {
+  int num_disks = configure.num_racks * configure.nodes_per_rack * configure.disks_per_node;
+  chunks_per_disk_ = (double)num_stripes_ * code_n_ / num_disks;
+}
+
+bool AnalyticModel::IsSupported(const Configure &configure, string *reason) {
+  if (configure.use_failure_trace) {
+    *reason = "failure_trace=1";
+    return false;
+  }
+  if (configure.disk_fail_dists.a() != 1.0) {
+    *reason = "failure times are not exponential";
+    return false;
+  }
+  if (configure.code_n <= configure.code_k) {
+    *reason = "invalid code_n and code_k";
+    return false;
+  }
+  return true;
+}
+
+int AnalyticModel::GetMaxFailures() {
+  if (strcmp(code_type_.c_str(), Placement::kCodeTypeLRC.c_str()) == 0) {
+    return code_n_ - code_k_ - code_l_;
+  }
+  return code_n_ - code_k_;
+}
+
+// Cross-rack chunks downloaded to rebuild one chunk of a stripe with
+// num_failed_chunks failed chunks.
+double AnalyticModel::GetRepairTraffic(int num_failed_chunks) {
+  if (num_failed_chunks == 1) {
+    if (strcmp(code_type_.c_str(), Placement::kCodeTypeLRC.c_str()) == 0) {
+      return code_k_ / code_l_;
+    }
+    if (strcmp(code_type_.c_str(), Placement::kCodeTypeDRC.c_str()) == 0) {
+      return code_k_ == 5 ? 1.0 : 2.0;
+    }
+  }
+  return code_k_;
+}
+
+double AnalyticModel::GetRepairRate(int num_failed_chunks) {
+  double repair_time = chunks_per_disk_ * GetRepairTraffic(num_failed_chunks) *
+    chunk_size_ / repair_bwth_ / 3600.0; // hours
+  return 1.0 / repair_time;
+}
+
+// Expected time from state 0 to data loss: solve -Q * T = 1 over the
+// transient states.
+double AnalyticModel::GetStripeMttdl() {
+  int num_states = GetMaxFailures() + 1;
+  vector<vector<double> > a(num_states, vector<double>(num_states, 0.0));
+  vector<double> b(num_states, 1.0), t;
+  for (int i = 0; i < num_states; i++) {
+    double fail = (code_n_ - i) * failure_rate_;
+    a[i][i] += fail;
+    if (i + 1 < num_states) a[i][i + 1] -= fail;
+    if (i == 0) continue;
+    if (!lazy_repair_) {
+      double repair = GetRepairRate(i);
+      a[i][i] += repair;
+      a[i][i - 1] -= repair;
+    } else if (i >= lazy_repair_threshold_) {
+      double repair = GetRepairRate(i);
+      a[i][i] += repair;
+      a[i][0] -= repair;
+    }
+  }
+  if (!SolveLinearSystem(a, b, &t)) {
+    return 0.0;
+  }
+  return t[0];
+}
+
+// Probability that any stripe loses data within the mission time.
+double AnalyticModel::GetPdl() {
+  double mttdl = GetStripeMttdl();
+  if (mttdl <= 0.0) return 1.0;
+  return -expm1(-(double)num_stripes_ * mission_time_ / mttdl);
+}
+
+bool SolveLinearSystem(vector<vector<double> > a, vector<double> b,
+    vector<double> *x) {
+  int n = b.size();
+  for (int col = 0; col < n; col++) {
+    int pivot = col;
+    for (int row = col + 1; row < n; row++) {
+      if (fabs(a[row][col]) > fabs(a[pivot][col])) pivot = row;
+    }
+    if (a[pivot][col] == 0.0) return false;
+    swap(a[col], a[pivot]);
+    swap(b[col], b[pivot]);
+    for (int row = col + 1; row < n; row++) {
+      double factor = a[row][col] / a[col][col];
+      if (factor == 0.0) continue;
+      for (int k = col; k < n; k++) {
+        a[row][k] -= factor * a[col][k];
+      }
+      b[row] -= factor * b[col];
+    }
+  }
+  x->assign(n, 0.0);
+  for (int row = n - 1; row >= 0; row--) {
+    double sum = b[row];
+    for (int k = row + 1; k < n; k++) {
+      sum -= a[row][k] * (*x)[k];
+    }
+    (*x)[row] = sum / a[row][row];
+  }
+  return true;
+}
@@ -0,0 +1,52 @@
+#ifndef SIMEDC_ANALYTIC_HPP_
+#define SIMEDC_ANALYTIC_HPP_
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "parser.hpp"
+#include "placement.hpp"
+using namespace std;
+
+// Continuous-time Markov chain of one stripe for independent exponential
+// disk failures (failure_trace=0 with Weibull shape 1). State i is the number
+// of failed chunks of the stripe; a failure moves i to i+1 with rate
+// (n-i)/scale, and a repair moves i to i-1 (eager) or to 0 (lazy, only from
+// the threshold on) with the rate of rebuilding a whole disk over the
+// cross-rack bandwidth, where each chunk needs the traffic computed as in
+// Simulation::ComputeRepairTrafficForStripe() with no alive chunk in the
+// same rack. State max_failures+1 is data loss.
+//
+// Stripes are treated as independent and repairs of different disks as
+// concurrent, so the estimate is optimistic when failures pile up.
+class AnalyticModel {
+  private:
+    string code_type_;
+    int code_n_, code_k_, code_l_;
+    bool lazy_repair_;
+    int lazy_repair_threshold_;
+    double failure_rate_; // per disk, per hour
+    double mission_time_;
+    long num_stripes_;
+    double chunks_per_disk_;
+    int chunk_size_;
+    double repair_bwth_;
+
+    double GetRepairTraffic(int num_failed_chunks);
+
+  public:
+    AnalyticModel(const Configure &configure);
+    static bool IsSupported(const Configure &configure, string *reason);
+    int GetMaxFailures();
+    double GetRepairRate(int num_failed_chunks);
+    double GetStripeMttdl(); // hours
+    double GetPdl();
+};
+
+// Solve a * x = b by Gaussian elimination with partial pivoting.
+bool SolveLinearSystem(vector<vector<double> > a, vector<double> b,
+    vector<double> *x);
+
+#endif
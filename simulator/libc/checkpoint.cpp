@@ -0,0 +1,190 @@
+#include "checkpoint.hpp"
+#include <sys/stat.h>
+#include <unistd.h>
+
+const string Checkpoint::kMagic = "simedc-checkpoint-2";
+
+// doubles are stored in hex so that the restored values are bit-identical
+static string DoubleToHex(double value) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%a", value);
+  return string(buf);
+}
+
+Checkpoint::Checkpoint(string fname, string fingerprint)
+  :fname_(fname), fingerprint_(fingerprint) {}
+
+void Checkpoint::SetOutputs(const vector<string> &output_fnames) {
+  output_fnames_.clear();
+  for (size_t i = 0; i < output_fnames.size(); i++) {
+    if (!output_fnames[i].empty()) output_fnames_.push_back(output_fnames[i]);
+  }
+}
+
+// 0 if the file does not exist
+static long GetFileSize(const string &fname) {
+  struct stat st;
+  return stat(fname.c_str(), &st) == 0 ? (long)st.st_size : 0;
+}
+
+string Checkpoint::GetThreadFname(int thread_id) {
+  return fname_ + ".t" + to_string(thread_id);
+}
+
+bool Checkpoint::WriteAtomically(string fname, string content) {
+  string tmp_fname = fname + ".tmp";
+  ofstream outfile(tmp_fname, ofstream::out | ofstream::trunc);
+  if (outfile.fail()) {
+    cout << "Fail to write checkpoint file " << tmp_fname << "!" << endl;
+    return false;
+  }
+  outfile << content;
+  outfile.close();
+  if (outfile.fail() || rename(tmp_fname.c_str(), fname.c_str()) != 0) {
+    cout << "Fail to write checkpoint file " << fname << "!" << endl;
+    return false;
+  }
+  return true;
+}
+
+bool Checkpoint::SaveThread(int thread_id, const ThreadState &state) {
+  stringstream s;
+  s << kMagic << "\n" << fingerprint_ << "\n";
+  s << state.cluster_idx << " " << state.iterations_done << "\n";
+  s << state.stats.data_loss.GetTrials() << " " << state.stats.data_loss.GetSuccesses() << "\n";
+  s << state.stats.lost_chunks.GetCount() << " " << DoubleToHex(state.stats.lost_chunks.GetMean());
+  s << " " << DoubleToHex(state.stats.lost_chunks.GetM2()) << "\n";
+  s << state.stats.num_failed_stripes << " " << state.stats.sum_lost_chunks;
+  s << " " << state.stats.sum_sq_lost_chunks << "\n";
+  s << state.generator << "\n";
+  state.stats.histograms.Save(s);
+  const ForegroundStats &foreground = state.stats.foreground;
+  s << foreground.hours.size();
+  for (size_t bin = 0; bin < foreground.hours.size(); bin++) {
+    s << " " << DoubleToHex(foreground.hours[bin]);
+    s << " " << DoubleToHex(foreground.degraded_chunk_hours[bin]);
+    s << " " << DoubleToHex(foreground.degraded_reads[bin]);
+    s << " " << DoubleToHex(foreground.extra_mb[bin]);
+  }
+  s << "\n";
+  return WriteAtomically(GetThreadFname(thread_id), s.str());
+}
+
+bool Checkpoint::LoadThread(int thread_id, ThreadState *state) {
+  ifstream infile(GetThreadFname(thread_id), ifstream::in);
+  if (infile.fail()) return false;
+  string magic, fingerprint, mean, m2;
+  unsigned long trials, successes, count;
+  getline(infile, magic);
+  getline(infile, fingerprint);
+  if (magic != kMagic || fingerprint != fingerprint_) return false;
+  infile >> state->cluster_idx >> state->iterations_done;
+  infile >> trials >> successes;
+  infile >> count >> mean >> m2;
+  infile >> state->stats.num_failed_stripes >> state->stats.sum_lost_chunks;
+  infile >> state->stats.sum_sq_lost_chunks;
+  // the extractor of the engine does not skip the end of the previous line
+  infile >> ws >> state->generator;
+  if (infile.fail() || !state->stats.histograms.Load(infile)) return false;
+  size_t num_bins;
+  infile >> num_bins;
+  for (size_t bin = 0; bin < num_bins && !infile.fail(); bin++) {
+    string hours, degraded_chunk_hours, degraded_reads, extra_mb;
+    infile >> hours >> degraded_chunk_hours >> degraded_reads >> extra_mb;
+    state->stats.foreground.Add(bin, strtod(hours.c_str(), NULL), 
+        strtod(degraded_chunk_hours.c_str(), NULL), strtod(degraded_reads.c_str(), NULL),
+        strtod(extra_mb.c_str(), NULL));
+  }
+  if (infile.fail()) return false;
+  state->stats.data_loss = ProportionStats(trials, successes);
+  state->stats.lost_chunks = RunningStats(count, strtod(mean.c_str(), NULL), 
+      strtod(m2.c_str(), NULL));
+  return true;
+}
+
+bool Checkpoint::SaveProgress(int next_cluster_idx) {
+  stringstream s;
+  s << kMagic << "\n" << fingerprint_ << "\n" << next_cluster_idx << "\n";
+  for (size_t i = 0; i < output_fnames_.size(); i++) {
+    s << GetFileSize(output_fnames_[i]) << " " << output_fnames_[i] << "\n";
+  }
+  return WriteAtomically(fname_, s.str());
+}
+
+bool Checkpoint::LoadProgress(int *next_cluster_idx) {
+  ifstream infile(fname_, ifstream::in);
+  if (infile.fail()) return false;
+  string magic, saved_fingerprint;
+  getline(infile, magic);
+  getline(infile, saved_fingerprint);
+  infile >> *next_cluster_idx;
+  if (infile.fail() || magic != kMagic) return false;
+  if (saved_fingerprint != fingerprint_) {
+    cout << "Checkpoint " << fname_ << " was taken with a different configuration, ignored!" << endl;
+    return false;
+  }
+  long size;
+  string output_fname;
+  while (infile >> size >> ws && getline(infile, output_fname)) {
+    if (GetFileSize(output_fname) > size && truncate(output_fname.c_str(), size) != 0) {
+      cout << "Fail to remove the rows written after the checkpoint from " << 
+        output_fname << "!" << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+string Checkpoint::GetFingerprint(const Configure &c) {
+  stringstream s;
+  s << "processes=" << c.num_processes << ";iterations=" << c.num_iterations;
+  s << ";mission=" << DoubleToHex(c.mission_time) << ";capacity=" << c.capacity_per_disk;
+  s << ";chunk_size=" << c.chunk_size;
+  s << ";code=" << c.code_type << "," << c.code_n << "," << c.code_k << "," << c.code_l;
+  s << ";fail_dist=" << DoubleToHex(c.disk_fail_dists.a()) << ",";
+  s << DoubleToHex(c.disk_fail_dists.b()) << ";network=" << c.use_network;
+  if (c.network_setting != NULL) {
+    s << "," << DoubleToHex(c.network_setting[0]) << "," << DoubleToHex(c.network_setting[1]);
+  }
+  s << ";failure_trace=" << c.use_failure_trace << "," << c.trace_fname;
+  s << ";lazy=" << c.lazy_repair << "," << c.lazy_repair_threshold;
+  s << ";seed=" << c.seed << ";res_fname=" << c.res_fname;
+  s << ";idx=" << c.start_idx << "," << c.end_idx << ";log_level=" << c.log_level;
+  s << ";event_trace=" << c.event_trace_fname;
+  for (set<int>::const_iterator it = c.event_trace_iters.begin(); 
+      it != c.event_trace_iters.end(); it++) {
+    s << "," << *it;
+  }
+  s << ";ci=" << c.ci_method << ";stats=" << c.stats_fname;
+  s << ";histograms=" << c.histogram_fname;
+  s << ";checkpoint_interval=" << c.checkpoint_interval << ";crn=";
+  for (size_t i = 0; i < c.crn_policies.size(); i++) {
+    s << c.crn_policies[i].name << ",";
+  }
+  const SyntheticSetting &synthetic = c.synthetic;
+  s << ";synthetic=";
+  for (size_t i = 0; i < synthetic.topologies.size(); i++) {
+    s << synthetic.topologies[i].disks_per_node << "x" << synthetic.topologies[i].nodes_per_rack;
+    s << "x" << synthetic.topologies[i].num_racks << ",";
+  }
+  s << DoubleToHex(synthetic.afr) << "," << DoubleToHex(synthetic.burst_prob) << ",";
+  s << DoubleToHex(synthetic.burst_size) << "," << synthetic.burst_scope << ",";
+  s << DoubleToHex(synthetic.burst_window) << "," << synthetic.dump_dir;
+  const ForegroundSetting &foreground = c.foreground;
+  s << ";foreground=" << DoubleToHex(foreground.read_rate) << ",";
+  s << DoubleToHex(foreground.read_size) << "," << foreground.num_bins << ",";
+  s << foreground.fname;
+  s << ";placement=" << c.place_type << "," << c.scatter_width << "," << c.compress_placement;
+  s << "," << c.placement_threads << "," << c.placement_load << "," << c.placement_dump;
+  s << "," << c.placement_dump_all << ";iteration_threads=" << c.iteration_threads;
+  s << ";stripe_kernel=" << c.stripe_kernel << ";danger_filter=" << c.danger_filter;
+  // FNV-1a, the fingerprint is kept on one line of the checkpoint files
+  string description = s.str();
+  unsigned long long hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < description.size(); i++) {
+    hash = (hash ^ (unsigned char)description[i]) * 1099511628211ULL;
+  }
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%016llx", hash);
+  return string(buf);
+}
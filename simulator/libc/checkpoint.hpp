@@ -0,0 +1,54 @@
+#ifndef SIMEDC_CHECKPOINT_HPP_
+#define SIMEDC_CHECKPOINT_HPP_
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "parser.hpp"
+#include "estimator.hpp"
+using namespace std;
+
+// Progress of one simulation thread on one cluster, taken between two
+// iterations.
+struct ThreadState {
+  int cluster_idx;
+  int iterations_done;
+  SimStats stats;
+  default_random_engine generator;
+};
+
+// Periodic checkpoints of a sweep. The main file [fname] records which
+// cluster the sweep has reached and the size of each output file at that
+// point; each thread keeps its own state in [fname].t[thread id]. Files are
+// replaced atomically via rename(), and files written with a different
+// configuration (fingerprint) are ignored. On resume, the rows that a
+// crashed run wrote after its last SaveProgress() are cut off, since the
+// cluster they belong to runs again.
+class Checkpoint {
+  private:
+    string fname_;
+    string fingerprint_;
+    vector<string> output_fnames_;
+    static const string kMagic;
+    bool WriteAtomically(string fname, string content);
+
+  public:
+    Checkpoint(string fname, string fingerprint);
+    // the files the sweep appends a row (or rows) to per cluster
+    void SetOutputs(const vector<string> &output_fnames);
+    string GetThreadFname(int thread_id);
+    bool SaveThread(int thread_id, const ThreadState &state);
+    bool LoadThread(int thread_id, ThreadState *state);
+    bool SaveProgress(int next_cluster_idx);
+    bool LoadProgress(int *next_cluster_idx);
+    // hash of the parsed configuration, which must not change between the
+    // interrupted and resumed run
+    static string GetFingerprint(const Configure &configure);
+};
+
+#endif
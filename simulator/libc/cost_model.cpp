@@ -0,0 +1,70 @@
+#include "cost_model.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+CostModel::CostModel()
+  :scale_(0), exponent_(1) {
+}
+
+double CostModel::GetChunks(const Configure &configure) {
+  return (double)configure.num_stripes * configure.code_n;
+}
+
+double CostModel::GetFailedChunks(const Configure &configure, const Meta &meta) {
+  double num_disks = (double)configure.num_racks * configure.nodes_per_rack *
+    configure.disks_per_node;
+  // the trace of one period is repeated over the mission time
+  double num_failures = meta.num_failures * configure.mission_time /
+    Trace("", 0).GetPeriod();
+  return num_failures * GetChunks(configure) / num_disks;
+}
+
+double CostModel::GetWork(const Configure &configure, const Meta &meta) {
+  return GetChunks(configure) + GetFailedChunks(configure, meta);
+}
+
+void CostModel::AddSample(const Configure &configure, const Meta &meta,
+    double seconds_per_iteration) {
+  works_.push_back(max(GetWork(configure, meta), 1.0));
+  seconds_.push_back(max(seconds_per_iteration, 1e-9));
+}
+
+void CostModel::Fit() {
+  int n = seconds_.size();
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (int i = 0; i < n; i++) {
+    double x = log(works_[i]), y = log(seconds_[i]);
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+  if (n == 0) return;
+  double var = sxx - sx * sx / n;
+  exponent_ = var > 1e-6 ? (sxy - sx * sy / n) / var : 1.0;
+  scale_ = exp((sy - exponent_ * sx) / n);
+}
+
+double CostModel::GetSecondsPerIteration(const Configure &configure,
+    const Meta &meta) const {
+  return scale_ * pow(max(GetWork(configure, meta), 1.0), exponent_);
+}
+
+double CostModel::GetMakespan(vector<double> tasks, int num_threads) {
+  sort(tasks.begin(), tasks.end(), greater<double>());
+  // time at which each thread becomes free
+  priority_queue<double, vector<double>, greater<double> > threads;
+  for (int i = 0; i < max(num_threads, 1); i++) {
+    threads.push(0.0);
+  }
+  double makespan = 0;
+  for (size_t i = 0; i < tasks.size(); i++) {
+    double end = threads.top() + tasks[i];
+    threads.pop();
+    threads.push(end);
+    makespan = max(makespan, end);
+  }
+  return makespan;
+}
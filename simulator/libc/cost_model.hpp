@@ -0,0 +1,34 @@
+#ifndef SIMEDC_COST_MODEL_HPP_
+#define SIMEDC_COST_MODEL_HPP_
+
+#include <vector>
+#include "parser.hpp"
+using namespace std;
+
+// Seconds per iteration of one scenario on a cluster, modelled as
+//   scale * work^exponent
+// where the work is the chunks placed in an iteration plus the chunks of the
+// disks that fail within the mission time, i.e., the chunks to repair. Lazy
+// repair grows faster than the work, hence the exponent. Both are fitted to
+// short calibration runs.
+class CostModel {
+  private:
+    vector<double> works_, seconds_;
+    double scale_, exponent_;
+
+  public:
+    CostModel();
+    static double GetChunks(const Configure &configure);
+    static double GetFailedChunks(const Configure &configure, const Meta &meta);
+    // chunks + failed chunks, also compares clusters without calibration
+    static double GetWork(const Configure &configure, const Meta &meta);
+    void AddSample(const Configure &configure, const Meta &meta, double seconds_per_iteration);
+    // least squares on the logarithms of the samples; with a single size of
+    // work, the time is proportional to the work
+    void Fit();
+    double GetSecondsPerIteration(const Configure &configure, const Meta &meta) const;
+    // wall time of tasks on num_threads threads, started largest first
+    static double GetMakespan(vector<double> tasks, int num_threads);
+};
+
+#endif
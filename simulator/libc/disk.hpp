@@ -1,3 +1,6 @@
+#ifndef SIMEDC_DISK_HPP_
+#define SIMEDC_DISK_HPP_
+
 #include <cstring>
 #include <string>
 #include <random>
@@ -36,3 +39,5 @@ class Disk{
     void RepairDisk(double curr_time);
     double GetUnavailTime(double curr_time);
 };
+
+#endif
@@ -0,0 +1,221 @@
+#include "estimator.hpp"
+
+RunningStats::RunningStats():count_(0), mean_(0.0), m2_(0.0) {}
+
+RunningStats::RunningStats(unsigned long count, double mean, double m2)
+  :count_(count), mean_(mean), m2_(m2) {}
+
+RunningStats RunningStats::FromSums(unsigned long count, double sum, 
+    double sum_sq) {
+  if (count == 0) return RunningStats();
+  double mean = sum / count;
+  double m2 = max(0.0, sum_sq - sum * mean);
+  return RunningStats(count, mean, m2);
+}
+
+void RunningStats::Add(double x) {
+  count_ ++;
+  double delta = x - mean_;
+  mean_ += delta / count_;
+  m2_ += delta * (x - mean_);
+}
+
+// Chan et al. pairwise update
+void RunningStats::Merge(const RunningStats &other) {
+  if (other.count_ == 0) return;
+  if (count_ == 0) {
+    *this = other;
+    return;
+  }
+  double n_a = count_, n_b = other.count_;
+  double delta = other.mean_ - mean_;
+  double n = n_a + n_b;
+  mean_ += delta * n_b / n;
+  m2_ += other.m2_ + delta * delta * n_a * n_b / n;
+  count_ += other.count_;
+}
+
+double RunningStats::GetVariance() const {
+  if (count_ < 2) return 0.0;
+  return m2_ / (count_ - 1.0);
+}
+
+double RunningStats::GetStdev() const {
+  return sqrt(GetVariance());
+}
+
+double RunningStats::GetStdError() const {
+  if (count_ == 0) return 0.0;
+  return GetStdev() / sqrt((double)count_);
+}
+
+ProportionStats::ProportionStats():trials_(0), successes_(0) {}
+
+ProportionStats::ProportionStats(unsigned long trials, unsigned long successes)
+  :trials_(trials), successes_(successes) {}
+
+void ProportionStats::Add(bool success) {
+  trials_ ++;
+  if (success) successes_ ++;
+}
+
+void ProportionStats::Merge(const ProportionStats &other) {
+  trials_ += other.trials_;
+  successes_ += other.successes_;
+}
+
+double ProportionStats::GetMean() const {
+  if (trials_ == 0) return 0.0;
+  return 1.0 * successes_ / trials_;
+}
+
+double ProportionStats::GetVariance() const {
+  if (trials_ < 2) return 0.0;
+  double mean = GetMean();
+  double sum = (trials_ - successes_) * mean * mean + 
+    successes_ * (1.0 - mean) * (1.0 - mean);
+  return sum / (trials_ - 1.0);
+}
+
+double ProportionStats::GetRelativeError(double z) const {
+  if (successes_ == 0) return 0.0;
+  double stdev = sqrt(GetVariance());
+  return (z * (stdev / sqrt((double)trials_))) / GetMean();
+}
+
+void ProportionStats::GetWilsonInterval(double z, double *low, double *high) const {
+  if (trials_ == 0) {
+    *low = 0.0;
+    *high = 1.0;
+    return;
+  }
+  double n = trials_;
+  double p = GetMean();
+  double denom = 1.0 + z * z / n;
+  double center = (p + z * z / (2.0 * n)) / denom;
+  double half = z * sqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n)) / denom;
+  *low = max(0.0, center - half);
+  *high = min(1.0, center + half);
+}
+
+// Exact interval from the quantiles of the beta distribution.
+void ProportionStats::GetClopperPearsonInterval(double alpha, double *low, 
+    double *high) const {
+  double n = trials_, x = successes_;
+  *low = (successes_ == 0) ? 0.0 : InverseIncompleteBeta(alpha / 2.0, x, n - x + 1.0);
+  *high = (successes_ == trials_) ? 1.0 : 
+    InverseIncompleteBeta(1.0 - alpha / 2.0, x + 1.0, n - x);
+}
+
+void ForegroundStats::Add(int bin, double bin_hours, double bin_degraded_chunk_hours,
+    double bin_degraded_reads, double bin_extra_mb) {
+  if ((int)hours.size() <= bin) {
+    hours.resize(bin + 1, 0);
+    degraded_chunk_hours.resize(bin + 1, 0);
+    degraded_reads.resize(bin + 1, 0);
+    extra_mb.resize(bin + 1, 0);
+  }
+  hours[bin] += bin_hours;
+  degraded_chunk_hours[bin] += bin_degraded_chunk_hours;
+  degraded_reads[bin] += bin_degraded_reads;
+  extra_mb[bin] += bin_extra_mb;
+}
+
+void ForegroundStats::Merge(const ForegroundStats &other) {
+  for (size_t bin = 0; bin < other.hours.size(); bin++) {
+    Add(bin, other.hours[bin], other.degraded_chunk_hours[bin], other.degraded_reads[bin],
+        other.extra_mb[bin]);
+  }
+}
+
+SimStats::SimStats()
+  :num_failed_stripes(0), sum_lost_chunks(0), sum_sq_lost_chunks(0) {}
+
+void SimStats::AddIteration(bool is_data_loss, int num_failed_stripes_iter,
+    int num_lost_chunks) {
+  data_loss.Add(is_data_loss);
+  lost_chunks.Add(num_lost_chunks);
+  num_failed_stripes += num_failed_stripes_iter;
+  sum_lost_chunks += num_lost_chunks;
+  sum_sq_lost_chunks += (unsigned long)num_lost_chunks * num_lost_chunks;
+}
+
+void SimStats::Merge(const SimStats &other) {
+  data_loss.Merge(other.data_loss);
+  lost_chunks.Merge(other.lost_chunks);
+  num_failed_stripes += other.num_failed_stripes;
+  sum_lost_chunks += other.sum_lost_chunks;
+  sum_sq_lost_chunks += other.sum_sq_lost_chunks;
+  placement_seconds.Merge(other.placement_seconds);
+  histograms.Merge(other.histograms);
+  foreground.Merge(other.foreground);
+}
+
+void PairedStats::AddIteration(bool is_data_loss, int num_lost_chunks, 
+    bool base_is_data_loss, int base_num_lost_chunks) {
+  data_loss_diff.Add((is_data_loss ? 1.0 : 0.0) - (base_is_data_loss ? 1.0 : 0.0));
+  lost_chunks_diff.Add((double)num_lost_chunks - base_num_lost_chunks);
+}
+
+void PairedStats::Merge(const PairedStats &other) {
+  data_loss_diff.Merge(other.data_loss_diff);
+  lost_chunks_diff.Merge(other.lost_chunks_diff);
+}
+
+// Continued fraction of the incomplete beta function (modified Lentz).
+static double BetaContinuedFraction(double x, double a, double b) {
+  const int kMaxIter = 300;
+  const double kEps = 1e-15, kTiny = 1e-300;
+  double qab = a + b, qap = a + 1.0, qam = a - 1.0;
+  double c = 1.0;
+  double d = 1.0 - qab * x / qap;
+  if (fabs(d) < kTiny) d = kTiny;
+  d = 1.0 / d;
+  double h = d;
+  for (int m = 1; m <= kMaxIter; m++) {
+    int m2 = 2 * m;
+    double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+    d = 1.0 + aa * d;
+    if (fabs(d) < kTiny) d = kTiny;
+    c = 1.0 + aa / c;
+    if (fabs(c) < kTiny) c = kTiny;
+    d = 1.0 / d;
+    h *= d * c;
+    aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+    d = 1.0 + aa * d;
+    if (fabs(d) < kTiny) d = kTiny;
+    c = 1.0 + aa / c;
+    if (fabs(c) < kTiny) c = kTiny;
+    d = 1.0 / d;
+    double del = d * c;
+    h *= del;
+    if (fabs(del - 1.0) < kEps) break;
+  }
+  return h;
+}
+
+// Regularized incomplete beta function I_x(a, b).
+double IncompleteBeta(double x, double a, double b) {
+  if (x <= 0.0) return 0.0;
+  if (x >= 1.0) return 1.0;
+  double ln_front = lgamma(a + b) - lgamma(a) - lgamma(b) + 
+    a * log(x) + b * log(1.0 - x);
+  if (x < (a + 1.0) / (a + b + 2.0)) {
+    return exp(ln_front) * BetaContinuedFraction(x, a, b) / a;
+  }
+  return 1.0 - exp(ln_front) * BetaContinuedFraction(1.0 - x, b, a) / b;
+}
+
+// x such that I_x(a, b) = p, by bisection.
+double InverseIncompleteBeta(double p, double a, double b) {
+  double low = 0.0, high = 1.0;
+  for (int i = 0; i < 100; i++) {
+    double mid = 0.5 * (low + high);
+    if (IncompleteBeta(mid, a, b) < p) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return 0.5 * (low + high);
+}
@@ -0,0 +1,107 @@
+#ifndef SIMEDC_ESTIMATOR_HPP_
+#define SIMEDC_ESTIMATOR_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "histogram.hpp"
+using namespace std;
+
+// Online mean and variance (Welford). Two instances can be merged, so every
+// thread keeps its own and the results are combined at the end.
+class RunningStats {
+  private:
+    unsigned long count_;
+    double mean_;
+    double m2_; // sum of squared deviations from the mean
+
+  public:
+    RunningStats();
+    RunningStats(unsigned long count, double mean, double m2);
+    static RunningStats FromSums(unsigned long count, double sum, double sum_sq);
+    void Add(double x);
+    void Merge(const RunningStats &other);
+    unsigned long GetCount() const { return count_; }
+    double GetMean() const { return mean_; }
+    double GetM2() const { return m2_; }
+    double GetVariance() const; // sample variance
+    double GetStdev() const;
+    double GetStdError() const; // standard error of the mean
+};
+
+// Estimator of a Bernoulli probability (e.g., PDL) from two counters.
+class ProportionStats {
+  private:
+    unsigned long trials_;
+    unsigned long successes_;
+
+  public:
+    ProportionStats();
+    ProportionStats(unsigned long trials, unsigned long successes);
+    void Add(bool success);
+    void Merge(const ProportionStats &other);
+    unsigned long GetTrials() const { return trials_; }
+    unsigned long GetSuccesses() const { return successes_; }
+    double GetMean() const;
+    double GetVariance() const; // sample variance of the 0/1 samples
+    // half width of the normal interval divided by the mean, 0 if no success
+    double GetRelativeError(double z) const;
+    void GetWilsonInterval(double z, double *low, double *high) const;
+    void GetClopperPearsonInterval(double alpha, double *low, double *high) const;
+};
+
+// Foreground reads of the iterations (read_rate), in num_bins intervals of
+// the mission time: the simulated hours, the chunk-hours spent degraded, and
+// the expected degraded reads and extra cross-rack traffic of their
+// reconstruction.
+struct ForegroundStats {
+  vector<double> hours;
+  vector<double> degraded_chunk_hours;
+  vector<double> degraded_reads;
+  vector<double> extra_mb;
+
+  void Add(int bin, double hours, double degraded_chunk_hours, double degraded_reads,
+      double extra_mb);
+  void Merge(const ForegroundStats &other);
+};
+
+// Sufficient statistics of one simulation thread (or of a whole cluster
+// after merging).
+struct SimStats {
+  ProportionStats data_loss;
+  RunningStats lost_chunks;
+  unsigned long num_failed_stripes;
+  // exact integer sums of lost chunks, used to merge shards of a run
+  unsigned long sum_lost_chunks;
+  unsigned long sum_sq_lost_chunks;
+  // wall time of generating the placement of an iteration, not checkpointed
+  RunningStats placement_seconds;
+  // recorded with histogram_fname
+  RepairHistograms histograms;
+  // recorded with read_rate
+  ForegroundStats foreground;
+
+  SimStats();
+  void AddIteration(bool is_data_loss, int num_failed_stripes, int num_lost_chunks);
+  void Merge(const SimStats &other);
+};
+
+// Per-iteration differences between a policy and the baseline policy when
+// both run on the same sample (common random numbers). The variance of the
+// difference is usually far smaller than the sum of the two variances.
+struct PairedStats {
+  RunningStats data_loss_diff;
+  RunningStats lost_chunks_diff;
+
+  void AddIteration(bool is_data_loss, int num_lost_chunks, 
+      bool base_is_data_loss, int base_num_lost_chunks);
+  void Merge(const PairedStats &other);
+};
+
+// 1.960 for 95% confidence
+const double kZ95 = 1.960;
+
+double IncompleteBeta(double x, double a, double b);
+double InverseIncompleteBeta(double p, double a, double b);
+
+#endif
@@ -0,0 +1,79 @@
+#include "event_trace.hpp"
+#include "disk.hpp"
+
+const size_t EventTrace::kBufferRecords = 4096;
+const uint32_t EventTrace::kVersion = 1;
+const int32_t EventTrace::kRecordIterationBegin = 0;
+const int32_t EventTrace::kRecordDiskFail = 1;
+const int32_t EventTrace::kRecordDiskRepair = 2;
+const int32_t EventTrace::kRecordDiskReplacement = 3;
+const int32_t EventTrace::kRecordChunkRepair = 4;
+const int32_t EventTrace::kRecordDataLoss = 5;
+const int32_t EventTrace::kRecordIterationEnd = 6;
+
+EventTrace::EventTrace():fp_(NULL) {}
+
+// Copies never share the file handle of the original.
+EventTrace::EventTrace(const EventTrace &event_trace):fp_(NULL) {}
+
+EventTrace &EventTrace::operator=(const EventTrace &event_trace) {
+  if (this != &event_trace) {
+    Close();
+  }
+  return *this;
+}
+
+EventTrace::~EventTrace() {
+  Close();
+}
+
+bool EventTrace::Open(string fname) {
+  Close();
+  fp_ = fopen(fname.c_str(), "wb");
+  if (fp_ == NULL) {
+    cout << "Fail to open event trace file " << fname << "!" << endl;
+    return false;
+  }
+  uint32_t record_size = sizeof(EventRecord);
+  fwrite("SIMEDCEV", 1, 8, fp_);
+  fwrite(&kVersion, sizeof(kVersion), 1, fp_);
+  fwrite(&record_size, sizeof(record_size), 1, fp_);
+  buffer_.reserve(kBufferRecords);
+  return true;
+}
+
+void EventTrace::Record(double event_time, int32_t event_type, int element_id,
+    double repair_bwth) {
+  if (fp_ == NULL) return;
+  EventRecord record = {event_time, repair_bwth, (int32_t)element_id, event_type};
+  buffer_.push_back(record);
+  if (buffer_.size() >= kBufferRecords) {
+    Flush();
+  }
+}
+
+void EventTrace::Record(double event_time, string event_type, int element_id,
+    double repair_bwth) {
+  Record(event_time, GetRecordType(event_type), element_id, repair_bwth);
+}
+
+void EventTrace::Flush() {
+  if (fp_ == NULL || buffer_.empty()) return;
+  fwrite(&buffer_[0], sizeof(EventRecord), buffer_.size(), fp_);
+  buffer_.clear();
+}
+
+void EventTrace::Close() {
+  if (fp_ == NULL) return;
+  Flush();
+  fclose(fp_);
+  fp_ = NULL;
+}
+
+int32_t EventTrace::GetRecordType(string event_type) {
+  if (event_type == Disk::kEventDiskFail) return kRecordDiskFail;
+  if (event_type == Disk::kEventDiskRepair) return kRecordDiskRepair;
+  if (event_type == Disk::kEventDiskReplacement) return kRecordDiskReplacement;
+  if (event_type == Disk::kEventChunkRepair) return kRecordChunkRepair;
+  return -1;
+}
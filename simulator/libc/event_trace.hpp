@@ -0,0 +1,54 @@
+#ifndef SIMEDC_EVENT_TRACE_HPP_
+#define SIMEDC_EVENT_TRACE_HPP_
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+using namespace std;
+
+// One fixed-size record of the binary event trace (24 bytes, little endian).
+struct EventRecord {
+  double event_time;
+  double repair_bwth;
+  int32_t element_id;
+  int32_t event_type;
+};
+
+// Compact binary dump of the events processed in selected iterations.
+// File layout: 8-byte magic "SIMEDCEV", uint32 version, uint32 record size,
+// followed by EventRecord entries. An iteration starts with a
+// kRecordIterationBegin record whose element_id is the iteration index; a
+// kRecordDataLoss record carries the number of lost stripes in element_id.
+class EventTrace {
+  private:
+    FILE *fp_;
+    vector<EventRecord> buffer_;
+    static const size_t kBufferRecords;
+
+  public:
+    static const uint32_t kVersion;
+    static const int32_t kRecordIterationBegin;
+    static const int32_t kRecordDiskFail;
+    static const int32_t kRecordDiskRepair;
+    static const int32_t kRecordDiskReplacement;
+    static const int32_t kRecordChunkRepair;
+    static const int32_t kRecordDataLoss;
+    static const int32_t kRecordIterationEnd;
+
+    EventTrace();
+    EventTrace(const EventTrace &event_trace);
+    EventTrace &operator=(const EventTrace &event_trace);
+    ~EventTrace();
+    bool Open(string fname);
+    bool IsOpen() const { return fp_ != NULL; }
+    void Record(double event_time, int32_t event_type, int element_id,
+        double repair_bwth);
+    void Record(double event_time, string event_type, int element_id,
+        double repair_bwth);
+    void Flush();
+    void Close();
+    static int32_t GetRecordType(string event_type);
+};
+
+#endif
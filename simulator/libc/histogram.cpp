@@ -0,0 +1,187 @@
+#include "histogram.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+Histogram::Histogram()
+  :first_bucket_(0), count_(0), zero_count_(0), sum_(0), min_(0), max_(0) {
+}
+
+// value = m * 2^e with m in [0.5, 1), bucket e * kSubBuckets + the sub-bucket
+// of m
+int Histogram::GetBucket(double value) {
+  int e;
+  double m = frexp(value, &e);
+  int sub = min((int)((m - 0.5) * 2 * kSubBuckets), kSubBuckets - 1);
+  return e * kSubBuckets + sub;
+}
+
+double Histogram::GetBucketLow(int bucket) {
+  // floor division, buckets of values below 1 are negative
+  int e = bucket >= 0 ? bucket / kSubBuckets : -((-bucket - 1) / kSubBuckets) - 1;
+  int sub = bucket - e * kSubBuckets;
+  return ldexp(0.5 + 0.5 * sub / kSubBuckets, e);
+}
+
+void Histogram::Grow(int bucket) {
+  if (counts_.empty()) {
+    first_bucket_ = bucket;
+    counts_.assign(1, 0);
+  } else if (bucket < first_bucket_) {
+    counts_.insert(counts_.begin(), first_bucket_ - bucket, 0);
+    first_bucket_ = bucket;
+  } else if (bucket >= first_bucket_ + (int)counts_.size()) {
+    counts_.resize(bucket - first_bucket_ + 1, 0);
+  }
+}
+
+void Histogram::Add(double value, unsigned long weight) {
+  if (weight == 0) return;
+  if (count_ == 0) {
+    min_ = max_ = value;
+  } else {
+    min_ = min(min_, value);
+    max_ = max(max_, value);
+  }
+  count_ += weight;
+  sum_ += value * weight;
+  if (value <= 0) {
+    zero_count_ += weight;
+    return;
+  }
+  int bucket = GetBucket(value);
+  Grow(bucket);
+  counts_[bucket - first_bucket_] += weight;
+}
+
+void Histogram::Merge(const Histogram &other) {
+  if (other.count_ == 0) return;
+  if (count_ == 0) {
+    *this = other;
+    return;
+  }
+  min_ = min(min_, other.min_);
+  max_ = max(max_, other.max_);
+  count_ += other.count_;
+  zero_count_ += other.zero_count_;
+  sum_ += other.sum_;
+  if (other.counts_.empty()) return;
+  Grow(other.first_bucket_);
+  Grow(other.first_bucket_ + other.counts_.size() - 1);
+  for (size_t i = 0; i < other.counts_.size(); i++) {
+    counts_[other.first_bucket_ + i - first_bucket_] += other.counts_[i];
+  }
+}
+
+double Histogram::GetMean() const {
+  return count_ > 0 ? sum_ / count_ : 0;
+}
+
+double Histogram::GetQuantile(double q) const {
+  if (count_ == 0) return 0;
+  double target = q * count_;
+  double seen = zero_count_;
+  if (seen >= target && zero_count_ > 0) return 0;
+  for (size_t i = 0; i < counts_.size(); i++) {
+    seen += counts_[i];
+    if (seen >= target && counts_[i] > 0) {
+      int bucket = first_bucket_ + i;
+      double middle = (GetBucketLow(bucket) + GetBucketLow(bucket + 1)) / 2;
+      return min(max(middle, min_), max_);
+    }
+  }
+  return max_;
+}
+
+string Histogram::FormatBuckets() const {
+  stringstream s;
+  char low[32];
+  if (zero_count_ > 0) {
+    s << "0:" << zero_count_;
+  }
+  for (size_t i = 0; i < counts_.size(); i++) {
+    if (counts_[i] == 0) continue;
+    snprintf(low, sizeof(low), "%.6g", GetBucketLow(first_bucket_ + i));
+    if (s.tellp() > 0) s << " ";
+    s << low << ":" << counts_[i];
+  }
+  return s.str();
+}
+
+static string DoubleToHex(double value) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%a", value);
+  return string(buf);
+}
+
+void Histogram::Save(ostream &out) const {
+  out << count_ << " " << zero_count_ << " " << DoubleToHex(sum_) << " ";
+  out << DoubleToHex(min_) << " " << DoubleToHex(max_) << " " << first_bucket_ << " ";
+  out << counts_.size();
+  for (size_t i = 0; i < counts_.size(); i++) {
+    out << " " << counts_[i];
+  }
+  out << "\n";
+}
+
+bool Histogram::Load(istream &in) {
+  string sum, min, max;
+  size_t num_buckets;
+  in >> count_ >> zero_count_ >> sum >> min >> max >> first_bucket_ >> num_buckets;
+  if (in.fail()) return false;
+  sum_ = strtod(sum.c_str(), NULL);
+  min_ = strtod(min.c_str(), NULL);
+  max_ = strtod(max.c_str(), NULL);
+  counts_.resize(num_buckets);
+  for (size_t i = 0; i < num_buckets; i++) {
+    in >> counts_[i];
+  }
+  return !in.fail();
+}
+
+void RepairHistograms::AddDegraded(int failed_chunks, double hours, unsigned long weight) {
+  if ((int)degraded_hours.size() <= failed_chunks) {
+    degraded_hours.resize(failed_chunks + 1);
+  }
+  degraded_hours[failed_chunks].Add(hours, weight);
+}
+
+void RepairHistograms::Merge(const RepairHistograms &other) {
+  repair_hours.Merge(other.repair_hours);
+  wait_hours.Merge(other.wait_hours);
+  repair_traffic_mb.Merge(other.repair_traffic_mb);
+  if (degraded_hours.size() < other.degraded_hours.size()) {
+    degraded_hours.resize(other.degraded_hours.size());
+  }
+  for (size_t i = 0; i < other.degraded_hours.size(); i++) {
+    degraded_hours[i].Merge(other.degraded_hours[i]);
+  }
+  data_loss_hours.Merge(other.data_loss_hours);
+}
+
+void RepairHistograms::Save(ostream &out) const {
+  repair_hours.Save(out);
+  wait_hours.Save(out);
+  repair_traffic_mb.Save(out);
+  out << degraded_hours.size() << "\n";
+  for (size_t i = 0; i < degraded_hours.size(); i++) {
+    degraded_hours[i].Save(out);
+  }
+  data_loss_hours.Save(out);
+}
+
+bool RepairHistograms::Load(istream &in) {
+  size_t num_levels;
+  if (!repair_hours.Load(in) || !wait_hours.Load(in) || !repair_traffic_mb.Load(in)) {
+    return false;
+  }
+  in >> num_levels;
+  if (in.fail()) return false;
+  degraded_hours.assign(num_levels, Histogram());
+  for (size_t i = 0; i < num_levels; i++) {
+    if (!degraded_hours[i].Load(in)) return false;
+  }
+  return data_loss_hours.Load(in);
+}
@@ -0,0 +1,59 @@
+#ifndef SIMEDC_HISTOGRAM_HPP_
+#define SIMEDC_HISTOGRAM_HPP_
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Histogram of non-negative values in log-spaced buckets (HDR-style): each
+// power of 2 is split into kSubBuckets buckets, so a value is known within
+// 1/kSubBuckets of itself whatever its magnitude. Adding a value is a frexp()
+// and an increment; two histograms are merged by adding their counts.
+class Histogram {
+  private:
+    vector<unsigned long> counts_; // of the buckets from first_bucket_ on
+    int first_bucket_;
+    unsigned long count_, zero_count_; // zero_count_: values <= 0
+    double sum_, min_, max_;
+    static int GetBucket(double value);
+    static double GetBucketLow(int bucket);
+    void Grow(int bucket);
+
+  public:
+    static const int kSubBuckets = 16;
+
+    Histogram();
+    void Add(double value, unsigned long weight = 1);
+    void Merge(const Histogram &other);
+    unsigned long GetCount() const { return count_; }
+    double GetMean() const;
+    double GetMin() const { return count_ > 0 ? min_ : 0; }
+    double GetMax() const { return count_ > 0 ? max_ : 0; }
+    // the value that a fraction q of the values do not exceed, as the middle
+    // of its bucket
+    double GetQuantile(double q) const;
+    // "low:count" of the non-empty buckets, low the lower bound of a bucket
+    string FormatBuckets() const;
+    // one line, doubles in hex so that a checkpoint restores them exactly
+    void Save(ostream &out) const;
+    bool Load(istream &in);
+};
+
+// Repair metrics of the iterations of a simulation thread, recorded with
+// histogram_fname (see Simulation::Run()).
+struct RepairHistograms {
+  Histogram repair_hours; // transfer time of a disk repair
+  Histogram wait_hours; // in the queue for cross-rack bandwidth
+  Histogram repair_traffic_mb; // cross-rack download of a disk repair
+  // time a stripe spends with i failed chunks, degraded_hours[i]
+  vector<Histogram> degraded_hours;
+  Histogram data_loss_hours; // time to data loss of the iterations with one
+
+  void AddDegraded(int failed_chunks, double hours, unsigned long weight);
+  void Merge(const RepairHistograms &other);
+  void Save(ostream &out) const;
+  bool Load(istream &in);
+};
+
+#endif
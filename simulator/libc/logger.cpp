@@ -0,0 +1,62 @@
+#include "logger.hpp"
+
+pthread_mutex_t Logger::mutex_ = PTHREAD_MUTEX_INITIALIZER;
+const size_t Logger::kBufferSize = 64 * 1024;
+
+const int Logger::kLogOff = 0;
+const int Logger::kLogError = 1;
+const int Logger::kLogInfo = 2;
+const int Logger::kLogDebug = 3;
+
+Logger::Logger():level_(kLogOff), thread_id_(0) {}
+
+Logger::Logger(int level, int thread_id)
+  :level_(level), thread_id_(thread_id) {
+  if (level_ > kLogOff) {
+    buffer_.reserve(kBufferSize);
+  }
+}
+
+// A copy starts with an empty buffer; pending lines stay with the original.
+Logger::Logger(const Logger &logger)
+  :level_(logger.level_), thread_id_(logger.thread_id_) {}
+
+Logger &Logger::operator=(const Logger &logger) {
+  if (this != &logger) {
+    Flush();
+    level_ = logger.level_;
+    thread_id_ = logger.thread_id_;
+  }
+  return *this;
+}
+
+Logger::~Logger() {
+  Flush();
+}
+
+void Logger::Log(int level, const char *format, ...) {
+  if (!Enabled(level)) return;
+  char line[1024];
+  int len = snprintf(line, sizeof(line), "[t%d] ", thread_id_);
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(line + len, sizeof(line) - len - 1, format, args);
+  va_end(args);
+  if (n < 0) return;
+  len += n;
+  if (len > (int)sizeof(line) - 2) len = sizeof(line) - 2;
+  line[len++] = '\n';
+  buffer_.append(line, len);
+  if (buffer_.size() >= kBufferSize) {
+    Flush();
+  }
+}
+
+void Logger::Flush() {
+  if (buffer_.empty()) return;
+  pthread_mutex_lock(&mutex_);
+  fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+  fflush(stdout);
+  pthread_mutex_unlock(&mutex_);
+  buffer_.clear();
+}
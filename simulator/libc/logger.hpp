@@ -0,0 +1,37 @@
+#ifndef SIMEDC_LOGGER_HPP_
+#define SIMEDC_LOGGER_HPP_
+
+#include <pthread.h>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+using namespace std;
+
+// Levelled logger owned by one simulation thread. Messages are kept in a
+// thread-local buffer and written out in large chunks, so threads do not
+// serialize on every line. Logging is off by default.
+class Logger {
+  private:
+    int level_;
+    int thread_id_;
+    string buffer_;
+    static pthread_mutex_t mutex_;
+    static const size_t kBufferSize;
+
+  public:
+    static const int kLogOff;
+    static const int kLogError;
+    static const int kLogInfo;
+    static const int kLogDebug;
+
+    Logger();
+    Logger(int level, int thread_id);
+    Logger(const Logger &logger);
+    Logger &operator=(const Logger &logger);
+    ~Logger();
+    bool Enabled(int level) const { return level <= level_; }
+    void Log(int level, const char *format, ...);
+    void Flush();
+};
+
+#endif
@@ -1,3 +1,6 @@
+#ifndef SIMEDC_NETWORK_HPP_
+#define SIMEDC_NETWORK_HPP_
+
 #include <iostream>
 #include <vector>
 using namespace std;
@@ -20,3 +23,5 @@ class Network {
     double GetAvailCrossRackRepairBwth();
     double GetAvailIntraRackRepairBwth(int rack_id);
 };
+
+#endif
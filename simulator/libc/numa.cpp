@@ -0,0 +1,124 @@
+#include "numa.hpp"
+#include <algorithm>
+#include <fstream>
+#include <pthread.h>
+#include <sstream>
+
+const string NumaTopology::kAffinityNone = "none";
+const string NumaTopology::kAffinityCompact = "compact";
+const string NumaTopology::kAffinityScatter = "scatter";
+
+// "0-3,8-11" to 0, 1, 2, 3, 8, 9, 10, 11
+bool NumaTopology::ParseCpuList(const string &list, vector<int> *cpus) {
+  stringstream ss(list);
+  string range;
+  while (getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") continue;
+    size_t dash = range.find('-');
+    try {
+      int first = stoi(range.substr(0, dash));
+      int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; cpu++) {
+        cpus->push_back(cpu);
+      }
+    } catch (...) {
+      return false;
+    }
+  }
+  return true;
+}
+
+NumaTopology::NumaTopology() {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &allowed);
+  }
+  cpu_node_.assign(CPU_SETSIZE, -1);
+  for (int node = 0; ; node++) {
+    ifstream in("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+    if (!in.is_open()) break;
+    string list;
+    getline(in, list);
+    vector<int> cpus, usable;
+    if (!ParseCpuList(list, &cpus)) break;
+    for (size_t i = 0; i < cpus.size(); i++) {
+      if (cpus[i] < CPU_SETSIZE && CPU_ISSET(cpus[i], &allowed)) usable.push_back(cpus[i]);
+    }
+    // nodes with memory only, or outside the cpuset of the process
+    if (usable.empty()) continue;
+    for (size_t i = 0; i < usable.size(); i++) {
+      cpu_node_[usable[i]] = node_cpus_.size();
+    }
+    node_cpus_.push_back(usable);
+  }
+  if (node_cpus_.empty()) {
+    vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        cpu_node_[cpu] = 0;
+        cpus.push_back(cpu);
+      }
+    }
+    node_cpus_.push_back(cpus);
+  }
+}
+
+bool NumaTopology::IsValidAffinity(const string &affinity) {
+  return affinity == kAffinityNone || affinity == kAffinityCompact ||
+    affinity == kAffinityScatter;
+}
+
+const NumaTopology &NumaTopology::Get() {
+  static NumaTopology topology;
+  return topology;
+}
+
+int NumaTopology::GetNodeOfCpu(int cpu) const {
+  if (cpu < 0 || cpu >= (int)cpu_node_.size()) return -1;
+  return cpu_node_[cpu];
+}
+
+int NumaTopology::GetCurrentNode() const {
+  return max(0, GetNodeOfCpu(sched_getcpu()));
+}
+
+vector<int> NumaTopology::GetThreadCpus(const string &affinity) const {
+  vector<int> cpus;
+  if (affinity == kAffinityCompact) {
+    for (int node = 0; node < GetNumNodes(); node++) {
+      cpus.insert(cpus.end(), node_cpus_[node].begin(), node_cpus_[node].end());
+    }
+  } else if (affinity == kAffinityScatter) {
+    size_t max_cpus = 0;
+    for (int node = 0; node < GetNumNodes(); node++) {
+      max_cpus = max(max_cpus, node_cpus_[node].size());
+    }
+    for (size_t i = 0; i < max_cpus; i++) {
+      for (int node = 0; node < GetNumNodes(); node++) {
+        if (i < node_cpus_[node].size()) cpus.push_back(node_cpus_[node][i]);
+      }
+    }
+  }
+  return cpus;
+}
+
+bool NumaTopology::PinCurrentThread(const vector<int> &cpus, cpu_set_t *previous) {
+  pthread_getaffinity_np(pthread_self(), sizeof(*previous), previous);
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (size_t i = 0; i < cpus.size(); i++) {
+    CPU_SET(cpus[i], &mask);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+}
+
+void NumaTopology::RestoreCurrentThread(const cpu_set_t &previous) {
+  pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+}
+
+bool NumaTopology::IsCurrentThreadPinned() {
+  cpu_set_t mask;
+  if (pthread_getaffinity_np(pthread_self(), sizeof(mask), &mask) != 0) return false;
+  return CPU_COUNT(&mask) == 1;
+}
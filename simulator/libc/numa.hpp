@@ -0,0 +1,45 @@
+#ifndef SIMEDC_NUMA_HPP_
+#define SIMEDC_NUMA_HPP_
+
+#include <sched.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+// CPUs of each NUMA node, read from /sys/devices/system/node; without it the
+// machine is one node. Only the CPUs the process may run on are kept. A
+// pinned thread stays on its node, and Linux allocates the pages it touches
+// first there, so memory built by a pinned thread is local to it.
+class NumaTopology {
+  private:
+    vector<vector<int> > node_cpus_;
+    vector<int> cpu_node_; // -1 for the CPUs the process may not use
+    NumaTopology();
+    static bool ParseCpuList(const string &list, vector<int> *cpus);
+
+  public:
+    static const string kAffinityNone;
+    static const string kAffinityCompact;
+    static const string kAffinityScatter;
+    static bool IsValidAffinity(const string &affinity);
+    // read once, shared by all threads
+    static const NumaTopology &Get();
+
+    int GetNumNodes() const { return node_cpus_.size(); }
+    const vector<int> &GetNodeCpus(int node) const { return node_cpus_[node]; }
+    int GetNodeOfCpu(int cpu) const;
+    // node of the CPU running the calling thread, 0 if unknown
+    int GetCurrentNode() const;
+    // CPU of the i-th thread of a pool: compact fills the CPUs of a node
+    // before the next one, scatter takes the nodes in turn; empty for none
+    vector<int> GetThreadCpus(const string &affinity) const;
+
+    // restrict the calling thread to cpus, its mask before is kept in
+    // *previous to restore it with RestoreCurrentThread()
+    static bool PinCurrentThread(const vector<int> &cpus, cpu_set_t *previous);
+    static void RestoreCurrentThread(const cpu_set_t &previous);
+    // whether the calling thread may only run on one CPU
+    static bool IsCurrentThreadPinned();
+};
+
+#endif
@@ -1,8 +1,15 @@
 #include "parser.hpp"
+#include "placement.hpp"
 
 Parser::Parser(string conf_fname):conf_fname_(conf_fname){}
 
 void Parser::GetConfiguration(Configure *configure) {
+  GetConfiguration(configure, map<string, string>());
+}
+
+// Values in overrides replace the ones in the configuration file.
+void Parser::GetConfiguration(Configure *configure, 
+    const map<string, string> &overrides) {
   ifstream infile(conf_fname_, ifstream::in);
   if (!infile.fail()) {
     string line, word;
@@ -18,48 +25,220 @@ void Parser::GetConfiguration(Configure *configure) {
         }
       }
     }
-    configure->num_processes = stoi(config_map[string("processes")]);
-    int num_iterations = stoi(config_map[string("iterations")]);
-    if (num_iterations % configure->num_processes != 0) {
-      cout << "num_iterations should be divisible by num_process!" << endl;
+    for (map<string, string>::const_iterator it = overrides.begin(); 
+        it != overrides.end(); it++) {
+      config_map[it->first] = it->second;
     }
-    int sub_num_iterations = num_iterations / configure->num_processes;
-    configure->num_iterations = sub_num_iterations;
-    configure->mission_time = stod(config_map[string("mission")]);
-    if (config_map.find(string("num_racks")) != config_map.end()) {
-      configure->num_racks = stoi(config_map[string("num_racks")]);
-      configure->nodes_per_rack = stoi(config_map[string("nodes_per_rack")]);
-      configure->disks_per_node = stoi(config_map[string("disks_per_node")]);
-      int num_disks = configure->num_racks * configure->nodes_per_rack * configure->disks_per_node;
-      configure->num_stripes = configure->capacity_per_disk * num_disks / configure->code_n / configure->chunk_size / 2;
-    }
-    configure->chunk_size = stoi(config_map[string("chunk_size")]);
-    configure->code_type = config_map[string("code_type")];
-    configure->code_n = stoi(config_map[string("code_n")]);
-    configure->code_k = stoi(config_map[string("code_k")]);
-    configure->use_failure_trace = stoi(config_map[string("failure_trace")]);
-    if (config_map.find(string("trace_fname")) != config_map.end()) {
-      configure->trace_fname = config_map[string("trace_fname")];
-    } else {
-      configure->trace_fname = "";
-    }
-    configure->lazy_repair = stoi(config_map[string("lazy_repair")]);
-    configure->lazy_repair_threshold = stoi(config_map[string("lazy_th")]);
-
-    configure->code_l = stoi(config_map[string("code_l")]);
-    configure->seed = stoi(config_map[string("seed")]);
-    configure->res_fname = config_map[string("res_fname")];
-    configure->start_idx = stoi(config_map[string("start_idx")]);
-    configure->end_idx = stoi(config_map[string("end_idx")]);
+    ParseConfiguration(config_map, configure);
+  } else {
+    cout << "Fail to open configuration file!" << endl;
+  }
+}
 
-    configure->use_network = true;
-    configure->capacity_per_disk = 512 * 1024;
-    weibull_distribution<double> disk_fail_dists(1.0, 8760/0.0116);
-    configure->disk_fail_dists = disk_fail_dists;
+// Configuration from the keys of a configuration file.
+void Parser::ParseConfiguration(map<string, string> config_map, Configure *configure) {
+  configure->num_processes = stoi(config_map[string("processes")]);
+  int num_iterations = stoi(config_map[string("iterations")]);
+  if (num_iterations % configure->num_processes != 0) {
+    cout << "num_iterations should be divisible by num_process!" << endl;
+  }
+  int sub_num_iterations = num_iterations / configure->num_processes;
+  configure->num_iterations = sub_num_iterations;
+  configure->mission_time = stod(config_map[string("mission")]);
+  if (config_map.find(string("num_racks")) != config_map.end()) {
+    configure->num_racks = stoi(config_map[string("num_racks")]);
+    configure->nodes_per_rack = stoi(config_map[string("nodes_per_rack")]);
+    configure->disks_per_node = stoi(config_map[string("disks_per_node")]);
+    int num_disks = configure->num_racks * configure->nodes_per_rack * configure->disks_per_node;
+    configure->num_stripes = configure->capacity_per_disk * num_disks / configure->code_n / configure->chunk_size / 2;
+  }
+  configure->chunk_size = stoi(config_map[string("chunk_size")]);
+  configure->code_type = config_map[string("code_type")];
+  configure->code_n = stoi(config_map[string("code_n")]);
+  if (configure->code_n > StripeKernel::kMaxChunks) {
+    cout << "code_n should be at most " << StripeKernel::kMaxChunks << "!" << endl;
+  }
+  configure->code_k = stoi(config_map[string("code_k")]);
+  configure->use_failure_trace = stoi(config_map[string("failure_trace")]);
+  if (config_map.find(string("trace_fname")) != config_map.end()) {
+    configure->trace_fname = config_map[string("trace_fname")];
+  } else {
+    configure->trace_fname = "";
+  }
+  configure->lazy_repair = stoi(config_map[string("lazy_repair")]);
+  configure->lazy_repair_threshold = stoi(config_map[string("lazy_th")]);
 
+  configure->code_l = stoi(config_map[string("code_l")]);
+  configure->seed = stoi(config_map[string("seed")]);
+  configure->res_fname = config_map[string("res_fname")];
+  configure->start_idx = stoi(config_map[string("start_idx")]);
+  configure->end_idx = stoi(config_map[string("end_idx")]);
+  configure->thread_id = 0;
+  if (config_map.find(string("log_level")) != config_map.end()) {
+    configure->log_level = stoi(config_map[string("log_level")]);
   } else {
-    cout << "Fail to open configuration file!" << endl;
+    configure->log_level = 0;
+  }
+  if (config_map.find(string("event_trace_fname")) != config_map.end()) {
+    configure->event_trace_fname = config_map[string("event_trace_fname")];
+    configure->event_trace_iters = ParseIndexList(config_map[string("event_trace_iters")]);
+  } else {
+    configure->event_trace_fname = "";
+  }
+  if (config_map.find(string("ci_method")) != config_map.end()) {
+    configure->ci_method = config_map[string("ci_method")];
+  } else {
+    configure->ci_method = "wilson";
+  }
+  if (config_map.find(string("stats_fname")) != config_map.end()) {
+    configure->stats_fname = config_map[string("stats_fname")];
+  } else {
+    configure->stats_fname = "";
   }
+  if (config_map.find(string("histogram_fname")) != config_map.end()) {
+    configure->histogram_fname = config_map[string("histogram_fname")];
+  } else {
+    configure->histogram_fname = "";
+  }
+  if (config_map.find(string("checkpoint_fname")) != config_map.end()) {
+    configure->checkpoint_fname = config_map[string("checkpoint_fname")];
+    configure->checkpoint_interval = stoi(config_map[string("checkpoint_interval")]);
+  } else {
+    configure->checkpoint_fname = "";
+    configure->checkpoint_interval = 0;
+  }
+  if (config_map.find(string("crn_policies")) != config_map.end()) {
+    ParsePolicies(config_map[string("crn_policies")], &configure->crn_policies);
+  } else {
+    configure->crn_policies.clear();
+  }
+  if (config_map.find(string("placement_compress")) != config_map.end()) {
+    configure->compress_placement = stoi(config_map[string("placement_compress")]);
+  } else {
+    configure->compress_placement = false;
+  }
+  if (config_map.find(string("placement_threads")) != config_map.end()) {
+    configure->placement_threads = max(1, stoi(config_map[string("placement_threads")]));
+  } else {
+    configure->placement_threads = 1;
+  }
+  if (config_map.find(string("iteration_threads")) != config_map.end()) {
+    configure->iteration_threads = max(1, stoi(config_map[string("iteration_threads")]));
+  } else {
+    configure->iteration_threads = 1;
+  }
+  if (config_map.find(string("placement_load")) != config_map.end()) {
+    configure->placement_load = config_map[string("placement_load")];
+  } else {
+    configure->placement_load = "";
+  }
+  if (config_map.find(string("placement_dump")) != config_map.end()) {
+    configure->placement_dump = config_map[string("placement_dump")];
+  } else {
+    configure->placement_dump = "";
+  }
+  if (config_map.find(string("placement_dump_all")) != config_map.end()) {
+    configure->placement_dump_all = stoi(config_map[string("placement_dump_all")]);
+  } else {
+    configure->placement_dump_all = false;
+  }
+  if (config_map.find(string("place_type")) != config_map.end()) {
+    configure->place_type = config_map[string("place_type")];
+    if (!PlacementStrategy::IsValidType(configure->place_type)) {
+      cout << "Wrong place_type " << configure->place_type << ", use flat!" << endl;
+      configure->place_type = Placement::kPlaceTypeFlat;
+    }
+  } else {
+    configure->place_type = Placement::kPlaceTypeFlat;
+  }
+  if (config_map.find(string("copyset_scatter_width")) != config_map.end()) {
+    configure->scatter_width = stoi(config_map[string("copyset_scatter_width")]);
+  } else {
+    configure->scatter_width = 0;
+  }
+  if (config_map.find(string("stripe_kernel")) != config_map.end()) {
+    configure->stripe_kernel = config_map[string("stripe_kernel")];
+    if (!StripeKernel::IsValidType(configure->stripe_kernel)) {
+      cout << "Wrong stripe_kernel " << configure->stripe_kernel << ", use auto!" << endl;
+      configure->stripe_kernel = StripeKernel::kTypeAuto;
+    } else if (!StripeKernel::IsSupported(configure->stripe_kernel)) {
+      cout << "stripe_kernel " << configure->stripe_kernel << 
+        " is not supported by this CPU, use auto!" << endl;
+      configure->stripe_kernel = StripeKernel::kTypeAuto;
+    }
+  } else {
+    configure->stripe_kernel = StripeKernel::kTypeAuto;
+  }
+  if (config_map.find(string("danger_filter")) != config_map.end()) {
+    configure->danger_filter = stoi(config_map[string("danger_filter")]);
+  } else {
+    configure->danger_filter = true;
+  }
+  ForegroundSetting &foreground = configure->foreground;
+  foreground.read_rate = 0.0;
+  if (config_map.find(string("read_rate")) != config_map.end()) {
+    foreground.read_rate = stod(config_map[string("read_rate")]);
+  }
+  foreground.read_size = configure->chunk_size;
+  if (config_map.find(string("read_size")) != config_map.end()) {
+    foreground.read_size = stod(config_map[string("read_size")]);
+  }
+  foreground.num_bins = 10;
+  if (config_map.find(string("foreground_bins")) != config_map.end()) {
+    foreground.num_bins = max(stoi(config_map[string("foreground_bins")]), 1);
+  }
+  foreground.fname = "";
+  if (config_map.find(string("foreground_fname")) != config_map.end()) {
+    foreground.fname = config_map[string("foreground_fname")];
+  }
+  SyntheticSetting &synthetic = configure->synthetic;
+  synthetic.topologies.clear();
+  if (config_map.find(string("synthetic_topology")) != config_map.end()) {
+    ParseTopologies(config_map[string("synthetic_topology")], &synthetic.topologies);
+  }
+  synthetic.afr = 0.0116;
+  if (config_map.find(string("synthetic_afr")) != config_map.end()) {
+    synthetic.afr = stod(config_map[string("synthetic_afr")]);
+  }
+  synthetic.burst_prob = 0.0;
+  if (config_map.find(string("synthetic_burst_prob")) != config_map.end()) {
+    synthetic.burst_prob = stod(config_map[string("synthetic_burst_prob")]);
+  }
+  synthetic.burst_size = 0.0;
+  if (config_map.find(string("synthetic_burst_size")) != config_map.end()) {
+    synthetic.burst_size = stod(config_map[string("synthetic_burst_size")]);
+  }
+  synthetic.burst_scope = "rack";
+  if (config_map.find(string("synthetic_burst_scope")) != config_map.end()) {
+    synthetic.burst_scope = config_map[string("synthetic_burst_scope")];
+  }
+  synthetic.burst_window = 1.0;
+  if (config_map.find(string("synthetic_burst_window")) != config_map.end()) {
+    synthetic.burst_window = stod(config_map[string("synthetic_burst_window")]);
+  }
+  synthetic.dump_dir = "";
+  if (config_map.find(string("synthetic_dump_dir")) != config_map.end()) {
+    synthetic.dump_dir = config_map[string("synthetic_dump_dir")];
+  }
+  configure->checkpoint = NULL;
+  configure->progress = NULL;
+  configure->progress_task = -1;
+  configure->cluster_idx = 0;
+  configure->first_iteration = 0;
+
+  configure->use_network = true;
+  configure->capacity_per_disk = 512 * 1024;
+  weibull_distribution<double> disk_fail_dists(1.0, 8760/0.0116);
+  configure->disk_fail_dists = disk_fail_dists;
+}
+
+void Parser::SetCluster(Configure *configure, const Meta &meta) {
+  configure->num_racks = meta.num_racks;
+  configure->nodes_per_rack = meta.nodes_per_rack;
+  configure->disks_per_node = meta.disks_per_node;
+  int num_disks = configure->num_racks * configure->nodes_per_rack * configure->disks_per_node;
+  configure->num_stripes = configure->capacity_per_disk * num_disks / configure->code_n / 
+    configure->chunk_size / 2;
 }
 
 void Parser::GetMeta(vector<Meta> *meta) {
@@ -133,3 +312,169 @@ void Parser::GetMeta(vector<Meta> *meta, string fname) {
     infile.close();
   }
 }
+
+// Parse a list of indices such as "0,3,10-12".
+set<int> Parser::ParseIndexList(string value) {
+  set<int> indices;
+  stringstream s(value);
+  string word;
+  while (getline(s, word, ',')) {
+    if (word.empty()) continue;
+    size_t dash = word.find('-', 1);
+    if (dash == string::npos) {
+      indices.insert(stoi(word));
+    } else {
+      int first = stoi(word.substr(0, dash));
+      int last = stoi(word.substr(dash + 1));
+      for (int i = first; i <= last; i++) {
+        indices.insert(i);
+      }
+    }
+  }
+  return indices;
+}
+
+// Parse "key=v1,v2,..." or "key=first..last". The key "code" takes code
+// names such as RS(10,4), LRC(12,2,2) and Rep(3).
+bool Parser::ParseSweep(string expr, vector<SweepValue> *values) {
+  size_t pos = expr.find('=');
+  if (pos == string::npos || pos == 0) {
+    cout << "Wrong sweep expression " << expr << "!" << endl;
+    return false;
+  }
+  string key = expr.substr(0, pos);
+  string value_list = expr.substr(pos + 1);
+  vector<string> words;
+  size_t range = value_list.find("..");
+  if (range != string::npos) {
+    int first = stoi(value_list.substr(0, range));
+    int last = stoi(value_list.substr(range + 2));
+    for (int i = first; i <= last; i++) {
+      words.push_back(to_string(i));
+    }
+  } else {
+    // split at the commas outside of parentheses
+    string word;
+    int depth = 0;
+    for (size_t i = 0; i < value_list.size(); i++) {
+      char c = value_list[i];
+      if (c == '(') depth ++;
+      if (c == ')') depth --;
+      if (c == ',' && depth == 0) {
+        words.push_back(word);
+        word.clear();
+      } else {
+        word += c;
+      }
+    }
+    words.push_back(word);
+  }
+  for (vector<string>::iterator it = words.begin(); it < words.end(); it++) {
+    if (it->empty()) continue;
+    SweepValue value;
+    if (key == "code") {
+      if (!ParseCode(*it, &value.overrides)) return false;
+      value.label = "";
+      for (size_t i = 0; i < it->size(); i++) {
+        char c = (*it)[i];
+        if (isalnum(c)) value.label += c;
+        if (c == ',') value.label += '-';
+      }
+    } else {
+      value.overrides[key] = *it;
+      value.label = key + *it;
+    }
+    values->push_back(value);
+  }
+  return true;
+}
+
+bool Parser::ParseCode(string code, map<string, string> *overrides) {
+  size_t open = code.find('('), close = code.find(')');
+  if (open == string::npos || close == string::npos || close < open) {
+    cout << "Wrong code " << code << "!" << endl;
+    return false;
+  }
+  string name = code.substr(0, open);
+  vector<int> args;
+  stringstream s(code.substr(open + 1, close - open - 1));
+  string word;
+  while (getline(s, word, ',')) {
+    args.push_back(stoi(word));
+  }
+  int code_n, code_k, code_l = 0;
+  if ((name == "RS" || name == "RSC") && args.size() == 2) {
+    (*overrides)["code_type"] = "RSC";
+    code_k = args[0];
+    code_n = args[0] + args[1];
+  } else if (name == "LRC" && args.size() == 3) {
+    (*overrides)["code_type"] = "LRC";
+    code_k = args[0];
+    code_l = args[1];
+    code_n = args[0] + args[1] + args[2];
+  } else if (name == "Rep" && args.size() == 1) {
+    (*overrides)["code_type"] = "Rep";
+    code_k = 1;
+    code_n = args[0];
+  } else {
+    cout << "Wrong code " << code << "!" << endl;
+    return false;
+  }
+  (*overrides)["code_n"] = to_string(code_n);
+  (*overrides)["code_k"] = to_string(code_k);
+  (*overrides)["code_l"] = to_string(code_l);
+  return true;
+}
+
+// Parse a list of repair policies such as "eager,lazy2,lazy3,lazy4".
+bool Parser::ParsePolicies(string value, vector<RepairPolicy> *policies) {
+  policies->clear();
+  stringstream s(value);
+  string word;
+  while (getline(s, word, ',')) {
+    if (word.empty()) continue;
+    RepairPolicy policy;
+    policy.name = word;
+    if (word == "eager") {
+      policy.lazy_repair = false;
+      policy.lazy_repair_threshold = 1;
+    } else if (word.compare(0, 4, "lazy") == 0 && word.size() > 4 && 
+        isdigit(word[4])) {
+      policy.lazy_repair = true;
+      policy.lazy_repair_threshold = stoi(word.substr(4));
+    } else {
+      cout << "Wrong repair policy " << word << "!" << endl;
+      policies->clear();
+      return false;
+    }
+    policies->push_back(policy);
+  }
+  return true;
+}
+
+// Parse a list of topologies "disks_per_node x nodes_per_rack x num_racks",
+// e.g., "4x16x32,8x20x200".
+bool Parser::ParseTopologies(string value, vector<Meta> *topologies) {
+  topologies->clear();
+  stringstream s(value);
+  string word;
+  while (getline(s, word, ',')) {
+    if (word.empty()) continue;
+    size_t first = word.find('x'), second = word.find('x', first + 1);
+    if (first == string::npos || second == string::npos) {
+      cout << "Wrong topology " << word << "!" << endl;
+      topologies->clear();
+      return false;
+    }
+    Meta one_meta;
+    one_meta.disks_per_node = stoi(word.substr(0, first));
+    one_meta.nodes_per_rack = stoi(word.substr(first + 1, second - first - 1));
+    one_meta.num_racks = stoi(word.substr(second + 1));
+    one_meta.total_disks = one_meta.disks_per_node * one_meta.nodes_per_rack * 
+      one_meta.num_racks;
+    one_meta.num_failures = 0;
+    one_meta.num_iterations = 0;
+    topologies->push_back(one_meta);
+  }
+  return true;
+}
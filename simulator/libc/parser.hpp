@@ -1,13 +1,63 @@
+#ifndef SIMEDC_PARSER_HPP_
+#define SIMEDC_PARSER_HPP_
+
+#include <cctype>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <random>
 #include <map>
+#include <set>
 #include <vector>
 #include "trace.hpp"
 using namespace std;
 
+class Checkpoint;
+class ProgressReporter;
+
+// A repair policy run in common-random-numbers mode, e.g., "eager" or "lazy3".
+struct RepairPolicy {
+  string name;
+  bool lazy_repair;
+  int lazy_repair_threshold;
+};
+
+struct Meta {
+  int num_racks;
+  int nodes_per_rack;
+  int disks_per_node;
+  int total_disks;
+  int num_failures;
+  int num_iterations;
+};
+
+// Synthetic clusters used instead of the meta file and the failure traces
+// of the dataset. A failure event hits a random disk; with probability
+// burst_prob it is a burst that also fails a Poisson(burst_size) number of
+// other disks of the same node or rack within burst_window hours. The rate
+// of events is set so that disks fail afr times per year on average.
+struct SyntheticSetting {
+  vector<Meta> topologies;
+  double afr;
+  double burst_prob;
+  double burst_size;
+  string burst_scope; // "node" or "rack"
+  double burst_window;
+  string dump_dir;
+};
+
+// Foreground workload (read_rate > 0): every disk serves read_rate reads of
+// read_size MB per second, spread evenly over its chunks. A read of a failed
+// chunk, on a crashed disk or left for a later lazy repair, is rebuilt from
+// the other chunks of its stripe, which costs cross-rack traffic.
+struct ForegroundSetting {
+  double read_rate; // reads per second per disk, 0 for none
+  double read_size; // MB
+  int num_bins; // intervals of the mission time in the results
+  string fname;
+};
+
 struct Configure {
   int num_processes;
   int num_iterations;
@@ -35,15 +85,40 @@ struct Configure {
   string res_fname;
   int start_idx;
   int end_idx;
+  int thread_id;
+  int log_level;
+  string event_trace_fname;
+  set<int> event_trace_iters;
+  string ci_method;
+  string stats_fname;
+  string histogram_fname; // repair histograms, recorded if not empty
+  string checkpoint_fname;
+  int checkpoint_interval;
+  Checkpoint *checkpoint;
+  ProgressReporter *progress; // iterations counted in task progress_task
+  int progress_task;
+  int cluster_idx;
+  int first_iteration;
+  vector<RepairPolicy> crn_policies;
+  SyntheticSetting synthetic;
+  ForegroundSetting foreground;
+  bool compress_placement;
+  int placement_threads;
+  int iteration_threads; // task pool of an iteration, 1 for none
+  string place_type;
+  int scatter_width; // copyset placement, 0 for code_n - 1
+  string placement_load;
+  string placement_dump;
+  bool placement_dump_all;
+  string stripe_kernel;
+  bool danger_filter;
 };
 
-struct Meta {
-  int num_racks;
-  int nodes_per_rack;
-  int disks_per_node;
-  int total_disks;
-  int num_failures;
-  int num_iterations;
+// One value of a swept parameter, e.g., "3" of "lazy_th=2..4" or
+// "RS(10,4)" of "code=RS(10,4),RS(12,4)", with the config keys it sets.
+struct SweepValue {
+  string label;
+  map<string, string> overrides;
 };
 
 class Parser {
@@ -52,6 +127,17 @@ class Parser {
   public:
     Parser(string conf_fname);
     void GetConfiguration(Configure *configure);
+    void GetConfiguration(Configure *configure, const map<string, string> &overrides);
+    static void ParseConfiguration(map<string, string> config_map, Configure *configure);
+    // topology of a cluster, and its number of stripes
+    static void SetCluster(Configure *configure, const Meta &meta);
     void GetMeta(vector<Meta> *meta);
     void GetMeta(vector<Meta> *meta, string fname);
+    static set<int> ParseIndexList(string value);
+    static bool ParseSweep(string expr, vector<SweepValue> *values);
+    static bool ParseCode(string code, map<string, string> *overrides);
+    static bool ParsePolicies(string value, vector<RepairPolicy> *policies);
+    static bool ParseTopologies(string value, vector<Meta> *topologies);
 };
+
+#endif
@@ -5,30 +5,72 @@ const string Placement::kCodeTypeLRC = "LRC"; //"Locally Repairable Codes";
 const string Placement::kCodeTypeDRC = "DRC"; //"Double Regenerating Codes";
 const string Placement::kCodeTypeReplication = "Rep"; //"Replication";
 
+const string Placement::kPlaceTypeFlat = "flat";
+const string Placement::kPlaceTypeCopyset = "copyset";
+const string Placement::kPlaceTypeRackGroup = "rackgroup";
+const string Placement::kPlaceTypeNode = "node";
+
 const int Placement::kLrcDataGroup[][6] = {{0, 1, 2, 3, 4, 5}, {8, 9, 10, 11, 12, 13}};
 const int Placement::kLrcLocalParity[] = {6, 14};
 const int Placement::kLrcGlobalParity[] = {7, 15};
 
-Placement::Placement(){}
-Placement::Placement(int num_racks) {num_racks_ = num_racks; }
+size_t HashDiskList::operator() (const vector<int> &disk_list) const {
+  size_t h = 0;
+  for (size_t i = 0; i < disk_list.size(); i++) {
+    h = h * 1000003 + disk_list[i];
+  }
+  return h;
+}
+
+PlacementOptions::PlacementOptions()
+  :compress(false), num_threads(1), place_type(Placement::kPlaceTypeFlat),
+   scatter_width(0), pool(NULL) {}
+
+Placement::Placement():code_n_(0), compress_(false), num_classes_(0), generator_(NULL), 
+  logger_(NULL){}
+Placement::Placement(int num_racks):code_n_(0), compress_(false), num_classes_(0), 
+  generator_(NULL), logger_(NULL) {num_racks_ = num_racks; }
 Placement::Placement(int num_racks, int nodes_per_rack, int disks_per_node, 
                      long capacity_per_disk, long num_stripes, int chunk_size, 
                      string code_type, int code_n, int code_k,
-                     int code_l, default_random_engine generator)
+                     int code_l, default_random_engine *generator,
+                     const PlacementOptions &options)
   :num_racks_(num_racks), nodes_per_rack_(nodes_per_rack), disks_per_node_(disks_per_node),
    capacity_per_disk_(capacity_per_disk), num_stripes_(num_stripes), 
    chunk_size_(chunk_size), code_type_(code_type), code_n_(code_n), code_k_(code_k),
-    code_l_(code_l), generator_(generator){
+    code_l_(code_l), compress_(options.compress), num_classes_(0), options_(options),
+    generator_(generator), logger_(NULL){
     num_disks_ = num_racks_ * nodes_per_rack_ * disks_per_node_;
     code_m_ = code_n_ - code_k_;
     num_chunks_ = code_n_ * num_stripes_;
     num_data_chunks_ = code_k_ * num_stripes_;
     disks_per_rack_ = disks_per_node_ * nodes_per_rack_;
     
+    if (!options_.load_fname.empty() && LoadPlacement(options_.load_fname)) {
+      return;
+    }
     GeneratePlacement();
     GenerateNumChunksPerDisk();
 }
 
+void Placement::SetLogger(Logger *logger) {
+  logger_ = logger;
+}
+
+// Stripes of blocks [first_block, last_block) of a placement, generated by
+// one thread.
+struct PlacementTask {
+  Placement *placement;
+  long first_block;
+  long last_block;
+};
+
+static void *GeneratePlacementBlocks(void *args) {
+  PlacementTask *task = (PlacementTask *)args;
+  task->placement->GenerateBlocks(task->first_block, task->last_block);
+  return 0;
+}
+
 bool Placement::GeneratePlacement(){
   // Check whether code settings are valid.
   if (code_k_ < 1 || code_n_ <= code_k_) {
@@ -39,90 +81,294 @@ bool Placement::GeneratePlacement(){
     cout << "code_l should NOT be 0 for LRC!" << endl;
     return false;
   }
-  // Generate flat placement: "Each chunk of a stripe resides in different rack"
+  // Each chunk of a stripe resides in different rack, for every place_type
   if (num_racks_ < code_n_ || disks_per_rack_ < 1) 
     return false;
-  for (int stripe_id = 0; stripe_id < num_stripes_; stripe_id++) {
-    vector<int> rack_list = GetDiffRacks(code_n_);
-    vector<int> disk_list;
-    vector<int>::iterator iter_rack;
-    for (iter_rack = rack_list.begin(); iter_rack < rack_list.end(); iter_rack++) {
-      disk_list.push_back(GetDiskRandomly(*iter_rack));
+  strategy_.reset(PlacementStrategy::Create(options_.place_type, num_racks_, nodes_per_rack_,
+        disks_per_node_, code_n_, options_.scatter_width));
+  if (!strategy_) {
+    cout << "Unknown place_type " << options_.place_type << "!" << endl;
+    return false;
+  }
+  // every block of stripes has its own stream derived from one draw of the
+  // thread's engine, so the placement does not depend on the number of threads
+  seed_[0] = (*generator_)();
+  seed_[1] = (*generator_)();
+  seed_seq seq = {seed_[0], seed_[1]};
+  default_random_engine generator(seq);
+  strategy_->Init(&generator);
+  long num_blocks = (num_stripes_ + kStripesPerBlock - 1) / kStripesPerBlock;
+  if (compress_) {
+    GenerateBlocks(0, num_blocks);
+    return true;
+  }
+  stripes_location_.resize((long)num_stripes_ * code_n_);
+  int num_threads = options_.pool ? options_.pool->GetNumThreads() : options_.num_threads;
+  num_threads = min((long)num_threads, num_blocks);
+  if (num_threads <= 1) {
+    GenerateBlocks(0, num_blocks);
+    return true;
+  }
+  vector<PlacementTask> tasks(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    tasks[i].placement = this;
+    tasks[i].first_block = num_blocks * i / num_threads;
+    tasks[i].last_block = num_blocks * (i + 1) / num_threads;
+  }
+  if (options_.pool != NULL) {
+    for (int i = 0; i < num_threads; i++) {
+      options_.pool->Submit(GeneratePlacementBlocks, &tasks[i]);
     }
-    stripes_location_.push_back(disk_list);
+    options_.pool->Wait();
+    return true;
+  }
+  vector<pthread_t> threads(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    pthread_create(&threads[i], NULL, GeneratePlacementBlocks, &tasks[i]);
+  }
+  for (int i = 0; i < num_threads; i++) {
+    pthread_join(threads[i], NULL);
   }
   return true;
 }
 
-// Randomly choose a disk from a rack with rack_id
-int Placement::GetDiskRandomly(int rack_id) {
-  int min_disk = rack_id * nodes_per_rack_ * disks_per_node_;
-  int disk_id = rand() % disks_per_rack_ + min_disk;
-  return disk_id;
+// Disks of the stripes of each block, chosen by the placement strategy from
+// the random stream of the block. With compress_, the stripes of a block are
+// merged into stripe classes.
+void Placement::GenerateBlocks(long first_block, long last_block) {
+  bool is_lrc = strcmp(code_type_.c_str(), kCodeTypeLRC.c_str()) == 0;
+  vector<int> scratch;
+  vector<int> disk_list(code_n_);
+  for (long block = first_block; block < last_block; block++) {
+    seed_seq seq = {seed_[0], seed_[1], (unsigned int)block};
+    default_random_engine generator(seq);
+    strategy_->InitScratch(&scratch);
+    long last_stripe = min((block + 1) * kStripesPerBlock, (long)num_stripes_);
+    for (long stripe_id = block * kStripesPerBlock; stripe_id < last_stripe; stripe_id++) {
+      strategy_->PlaceStripe(&generator, &scratch, disk_list.data());
+      if (!compress_) {
+        copy(disk_list.begin(), disk_list.end(), 
+            stripes_location_.begin() + stripe_id * code_n_);
+        continue;
+      }
+      // only LRC tells the chunks of a stripe apart
+      vector<int> key = disk_list;
+      if (!is_lrc) {
+        sort(key.begin(), key.end());
+      }
+      unordered_map<vector<int>, int, HashDiskList>::iterator it = stripe_classes_.find(key);
+      if (it == stripe_classes_.end()) {
+        stripe_classes_[key] = stripe_weights_.size();
+        stripes_location_.insert(stripes_location_.end(), key.begin(), key.end());
+        stripe_weights_.push_back(1);
+      } else {
+        stripe_weights_[it->second] ++;
+      }
+    }
+  }
+}
+
+// A step of the disk index built by one task of the pool.
+struct DiskIndexTask {
+  Placement *placement;
+  int step;
+  int task;
+  int num_tasks;
+  vector<vector<int> > *positions;
+};
+
+static void *BuildDiskIndexTask(void *args) {
+  DiskIndexTask *task = (DiskIndexTask *)args;
+  task->placement->BuildDiskIndex(task->step, task->task, task->num_tasks, task->positions);
+  return 0;
 }
 
-vector<int> Placement::GetDiffRacks(int num_diff_racks){
-  if (num_racks_ < num_diff_racks)
-    cout << "Wrong num_diff_racks in GetDiffRacks()!" << endl;
-  vector<int> diff_racks;
-  bool check;
-  if (num_diff_racks * 2.0 < num_racks_) {
-    diff_racks.resize(num_diff_racks, 0);
-    for (int i = 0; i < num_diff_racks; i++) {
-      check = false;
-      do {
-        diff_racks[i] = rand() % (num_racks_ - 1);
-        check = true;
-        for (int j = 0; (check) && j < i; j++) {
-          check = (diff_racks[i] != diff_racks[j]);
+// Stripes of each disk in compressed sparse row format. With a pool, each
+// task counts and then places the stripes of a range, which keeps the
+// stripes of every disk in increasing order as with one thread.
+void Placement::GenerateNumChunksPerDisk(){
+  num_classes_ = stripes_location_.size() / code_n_;
+  int num_classes = GetNumStripeClasses();
+  num_chunks_per_disk_ = vector<int>(num_disks_, 0);
+  disk_offsets_ = vector<long>(num_disks_ + 1, 0);
+  int num_tasks = options_.pool ? options_.pool->GetNumThreads() : 1;
+  num_tasks = min(num_tasks, num_classes / kStripesPerBlock);
+  if (num_tasks > 1) {
+    vector<vector<int> > positions(num_tasks, vector<int>(num_disks_, 0));
+    vector<DiskIndexTask> tasks(num_tasks);
+    for (int step = 0; step < 4; step++) {
+      if (step == 2) {
+        for (int disk_id = 0; disk_id < num_disks_; disk_id++) {
+          disk_offsets_[disk_id + 1] += disk_offsets_[disk_id];
         }
-      }while(check == false);
+        stripes_per_disk_.resize(disk_offsets_[num_disks_]);
+      }
+      for (int i = 0; i < num_tasks; i++) {
+        DiskIndexTask task = {this, step, i, num_tasks, &positions};
+        tasks[i] = task;
+        options_.pool->Submit(BuildDiskIndexTask, &tasks[i]);
+      }
+      options_.pool->Wait();
     }
-  } else {
-    // optimize: num_racks_ too few
-    for (int idx = 0; idx < num_racks_; idx++) {
-      diff_racks.push_back(idx);
+    stripe_classes_.clear();
+    return;
+  }
+  for (int stripe_id = 0; stripe_id < num_classes; stripe_id++) {
+    for (int i = 0; i < code_n_; i++) {
+      int disk_id = stripes_location_[(long)stripe_id * code_n_ + i];
+      num_chunks_per_disk_[disk_id] += GetStripeWeight(stripe_id);
+      disk_offsets_[disk_id + 1] ++;
     }
-    int num_racks_removed = num_racks_ - num_diff_racks;
-    vector<int>::iterator it;
-    for (int i = 0; i < num_racks_removed; i++) {
-      check = false;
-      do {
-        int rack_id_removed = rand() % (num_racks_ - 1);
-        it = find(diff_racks.begin(), diff_racks.end(), rack_id_removed);
-        if (it != diff_racks.end()) {
-          check = true;
-          diff_racks.erase(it);
-        }
-      }while(check == false);
+  }
+  for (int disk_id = 0; disk_id < num_disks_; disk_id++) {
+    disk_offsets_[disk_id + 1] += disk_offsets_[disk_id];
+  }
+  stripes_per_disk_.resize(disk_offsets_[num_disks_]);
+  vector<long> next(disk_offsets_.begin(), disk_offsets_.end() - 1);
+  for (int stripe_id = 0; stripe_id < num_classes; stripe_id++) {
+    for (int i = 0; i < code_n_; i++) {
+      int disk_id = stripes_location_[(long)stripe_id * code_n_ + i];
+      stripes_per_disk_[next[disk_id] ++] = stripe_id;
     }
-    shuffle(diff_racks.begin(), diff_racks.end(), generator_);
   }
-  return diff_racks;
+  stripe_classes_.clear();
 }
 
-void Placement::GenerateNumChunksPerDisk(){
-  num_chunks_per_disk_ = vector<int>(num_disks_, 0);
-  stripes_per_disk_.resize(num_disks_ + 1);
-  for (int stripe_id = 0; stripe_id < num_stripes_; stripe_id++) {
-    vector<int>::iterator iter_disk;
-    for (iter_disk = stripes_location_[stripe_id].begin(); iter_disk < stripes_location_[stripe_id].end(); iter_disk++) {
-      num_chunks_per_disk_[*iter_disk] ++;
-      stripes_per_disk_[*iter_disk].push_back(stripe_id);
+// Steps 0 and 2 go over a range of the stripes, 1 and 3 over a range of the
+// disks: 0 counts the stripes of each disk, 1 turns the counts into places,
+// 2 stores the stripes, 3 sums the chunks of each disk.
+void Placement::BuildDiskIndex(int step, int task, int num_tasks, 
+    vector<vector<int> > *positions) {
+  int num_classes = GetNumStripeClasses();
+  int first_stripe = (long)num_classes * task / num_tasks;
+  int last_stripe = (long)num_classes * (task + 1) / num_tasks;
+  int first_disk = (long)num_disks_ * task / num_tasks;
+  int last_disk = (long)num_disks_ * (task + 1) / num_tasks;
+  vector<int> &position = (*positions)[task];
+  if (step == 0 || step == 2) {
+    for (int stripe_id = first_stripe; stripe_id < last_stripe; stripe_id++) {
+      for (int i = 0; i < code_n_; i++) {
+        int disk_id = stripes_location_[(long)stripe_id * code_n_ + i];
+        if (step == 0) {
+          position[disk_id] ++;
+        } else {
+          stripes_per_disk_[disk_offsets_[disk_id] + position[disk_id]++] = stripe_id;
+        }
+      }
+    }
+  } else if (step == 1) {
+    for (int disk_id = first_disk; disk_id < last_disk; disk_id++) {
+      int num_stripes = 0;
+      for (int i = 0; i < num_tasks; i++) {
+        int count = (*positions)[i][disk_id];
+        (*positions)[i][disk_id] = num_stripes;
+        num_stripes += count;
+      }
+      disk_offsets_[disk_id + 1] = num_stripes;
+    }
+  } else {
+    for (int disk_id = first_disk; disk_id < last_disk; disk_id++) {
+      IdRange stripes = GetStripesOfDisk(disk_id);
+      int num_chunks = stripes.size();
+      if (compress_) {
+        num_chunks = 0;
+        for (const int *iter_stripe = stripes.begin(); iter_stripe < stripes.end(); iter_stripe++) {
+          num_chunks += GetStripeWeight(*iter_stripe);
+        }
+      }
+      num_chunks_per_disk_[disk_id] = num_chunks;
     }
   }
 }
 
+// Map a placement file written by Dump() with the same topology, code and
+// number of stripes, in place of generating one.
+bool Placement::LoadPlacement(const string &fname) {
+  shared_ptr<Snapshot> snapshot(new Snapshot());
+  if (!snapshot->Open(fname)) {
+    return false;
+  }
+  const SnapshotHeader &header = snapshot->GetHeader();
+  if (header.num_racks != num_racks_ || header.nodes_per_rack != nodes_per_rack_ ||
+      header.disks_per_node != disks_per_node_ || header.code_n != code_n_ ||
+      header.code_k != code_k_ || header.code_l != code_l_ ||
+      strncmp(header.code_type, code_type_.c_str(), sizeof(header.code_type)) != 0 ||
+      header.num_stripes != num_stripes_) {
+    cout << fname << " was written for another topology, code or number of stripes!" << endl;
+    return false;
+  }
+  stripes_location_.clear();
+  stripes_per_disk_.clear();
+  disk_offsets_.clear();
+  stripe_weights_.clear();
+  compress_ = header.compress != 0;
+  num_classes_ = header.num_classes;
+  seed_[0] = header.seed[0];
+  seed_[1] = header.seed[1];
+  snapshot_ = snapshot;
+  return true;
+}
+
+bool Placement::Dump(const string &fname) {
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  header.num_racks = num_racks_;
+  header.nodes_per_rack = nodes_per_rack_;
+  header.disks_per_node = disks_per_node_;
+  header.code_n = code_n_;
+  header.code_k = code_k_;
+  header.code_l = code_l_;
+  strncpy(header.code_type, code_type_.c_str(), sizeof(header.code_type) - 1);
+  strncpy(header.place_type, options_.place_type.c_str(), sizeof(header.place_type) - 1);
+  header.compress = compress_;
+  header.seed[0] = seed_[0];
+  header.seed[1] = seed_[1];
+  header.num_stripes = num_stripes_;
+  header.num_classes = num_classes_;
+  if (snapshot_) {
+    header.num_entries = snapshot_->GetDiskOffsets()[num_disks_];
+    return Snapshot::Write(fname, header, snapshot_->GetLocation(),
+        compress_ ? snapshot_->GetWeights() : NULL, snapshot_->GetDiskOffsets(),
+        snapshot_->GetStripesPerDisk());
+  }
+  header.num_entries = stripes_per_disk_.size();
+  return Snapshot::Write(fname, header, stripes_location_.data(),
+      compress_ ? stripe_weights_.data() : NULL, disk_offsets_.data(),
+      stripes_per_disk_.data());
+}
+
 vector<int> Placement::GetStripesToRepair(int failed_disk_id) {
-  if (failed_disk_id < 0 || failed_disk_id >= num_disks_)
+  if (failed_disk_id < 0 || failed_disk_id >= num_disks_) {
     cout << "Wrong failed_disk_id in GetStripesToRepair()!" << endl;
-  return stripes_per_disk_[failed_disk_id];
+    return vector<int>();
+  }
+  IdRange stripes = GetStripesOfDisk(failed_disk_id);
+  return vector<int>(stripes.begin(), stripes.end());
 }
 
 vector<int> Placement::GetStripeLocation(int stripe_id) {
-  if (stripe_id < 0 || stripe_id >= num_stripes_)
+  if (stripe_id < 0 || stripe_id >= GetNumStripeClasses()) {
     cout << "Wrong stripe_id in GetStripeLocation()!" << endl;
-  return stripes_location_[stripe_id];
+    return vector<int>();
+  }
+  IdRange disks = GetDisksOfStripe(stripe_id);
+  return vector<int>(disks.begin(), disks.end());
+}
+
+int Placement::GetMaxChunksPerDisk() {
+  int max_chunks = 0;
+  for (int disk_id = 0; disk_id < num_disks_; disk_id++) {
+    IdRange stripes = GetStripesOfDisk(disk_id);
+    int num_chunks = stripes.size();
+    if (compress_) {
+      num_chunks = 0;
+      for (const int *iter_stripe = stripes.begin(); iter_stripe < stripes.end(); iter_stripe++) {
+        num_chunks += GetStripeWeight(*iter_stripe);
+      }
+    }
+    max_chunks = max(max_chunks, num_chunks);
+  }
+  return max_chunks;
 }
 
 bool Placement::CheckDataLoss(vector<int> failed_disks_list, int *num_failed_stripes,
@@ -131,7 +377,7 @@ bool Placement::CheckDataLoss(vector<int> failed_disks_list, int *num_failed_str
   vector<int>::iterator iter_disk;
   // find all stripes that need to repair
   for (iter_disk = failed_disks_list.begin(); iter_disk < failed_disks_list.end(); iter_disk++) {
-    vector<int> stripes = GetStripesToRepair(*iter_disk);
+    IdRange stripes = GetStripesOfDisk(*iter_disk);
     stripe_id_set.insert(stripes.begin(), stripes.end());
   }
 
@@ -183,8 +429,8 @@ bool Placement::CheckDataLoss(vector<int> failed_disks_list, int *num_failed_str
         sum += stripe_failed_disks_num[gid];
       }
       if (sum > code_n_ - code_k_ - code_l_) {
-        (*num_failed_stripes) ++;
-        *num_lost_chunks += cur_stripe_lost_chunks_num;
+        (*num_failed_stripes) += GetStripeWeight(*iter_stripe);
+        *num_lost_chunks += cur_stripe_lost_chunks_num * GetStripeWeight(*iter_stripe);
         data_loss = true;
       } 
     }
@@ -203,13 +449,15 @@ bool Placement::CheckDataLoss(vector<int> failed_disks_list, int *num_failed_str
         }
       }
       if (stripe_failed_disks_num > code_m_) {
-        cout << "placement === " << stripe_failed_disks_num << endl;
-        for (iter_disk = stripe_failed_disks.begin(); iter_disk < stripe_failed_disks.end(); iter_disk++) {
-          cout << *iter_disk << " ";
+        if (logger_ != NULL && logger_->Enabled(Logger::kLogDebug)) {
+          string disks;
+          for (iter_disk = stripe_failed_disks.begin(); iter_disk < stripe_failed_disks.end(); iter_disk++) {
+            disks += to_string(*iter_disk) + " ";
+          }
+          logger_->Log(Logger::kLogDebug, "placement === %d: %s", stripe_failed_disks_num, disks.c_str());
         }
-        cout << endl;
-        (*num_failed_stripes) ++;
-        *num_lost_chunks += stripe_failed_disks_num;
+        (*num_failed_stripes) += GetStripeWeight(*iter_stripe);
+        *num_lost_chunks += stripe_failed_disks_num * GetStripeWeight(*iter_stripe);
         data_loss = true;
       }
     }
@@ -217,6 +465,62 @@ bool Placement::CheckDataLoss(vector<int> failed_disks_list, int *num_failed_str
   return data_loss;
 }
 
+int Placement::CountLrcUnrecoverable(unsigned long long failed) {
+  int sum = 0;
+  for (int i = 0; i < 2; i++) {
+    if (failed >> kLrcGlobalParity[i] & 1) sum ++;
+  }
+  for (int gid = 0; gid < code_l_; gid++) {
+    int group_failed = 0;
+    for (int i = 0; i < 6; i++) {
+      if (failed >> kLrcDataGroup[gid][i] & 1) group_failed ++;
+    }
+    // an alive local parity repairs one failed data chunk of its group
+    if (group_failed > 0 && !(failed >> kLrcLocalParity[gid] & 1)) group_failed --;
+    sum += group_failed;
+  }
+  return sum;
+}
+
+//overloaded function
+bool Placement::CheckDataLoss(const vector<int> &stripes, const StripeKernel &kernel,
+    const unsigned char *disk_failed, int *num_failed_stripes, int *num_lost_chunks) {
+  *num_failed_stripes = 0;
+  *num_lost_chunks = 0;
+  bool data_loss = false;
+  bool is_lrc = strcmp(code_type_.c_str(), kCodeTypeLRC.c_str()) == 0;
+
+  vector<int>::const_iterator iter_stripe;
+  for (iter_stripe = stripes.begin(); iter_stripe < stripes.end(); iter_stripe++) {
+    IdRange stripe_disks_id = GetDisksOfStripe(*iter_stripe);
+    StripeMasks masks = kernel.Evaluate(stripe_disks_id.begin(), code_n_, disk_failed,
+        NULL, -1, -1);
+    int cur_stripe_lost_chunks_num = __builtin_popcountll(masks.failed);
+    bool lost;
+    if (is_lrc) {
+      lost = CountLrcUnrecoverable(masks.failed) > code_n_ - code_k_ - code_l_;
+    } else {
+      lost = cur_stripe_lost_chunks_num > code_m_;
+    }
+    if (lost) {
+      if (logger_ != NULL && logger_->Enabled(Logger::kLogDebug)) {
+        string disks;
+        vector<int> chunks;
+        GetChunkIndices(masks.failed, &chunks);
+        for (vector<int>::iterator it = chunks.begin(); it < chunks.end(); it++) {
+          disks += to_string(stripe_disks_id.begin()[*it]) + " ";
+        }
+        logger_->Log(Logger::kLogDebug, "placement === %d: %s", cur_stripe_lost_chunks_num,
+            disks.c_str());
+      }
+      (*num_failed_stripes) += GetStripeWeight(*iter_stripe);
+      *num_lost_chunks += cur_stripe_lost_chunks_num * GetStripeWeight(*iter_stripe);
+      data_loss = true;
+    }
+  }
+  return data_loss;
+}
+
 //overloaded function
 bool Placement::CheckDataLoss(map<int, vector<int> > stripe_disks_to_repair, 
     int *num_failed_stripes, int *num_lost_chunks) {
@@ -271,9 +575,11 @@ bool Placement::CheckDataLoss(map<int, vector<int> > stripe_disks_to_repair,
         sum += stripe_failed_disks_num[gid];
       }
       if (sum > code_n_ - code_k_ - code_l_) {
-        (*num_failed_stripes) ++;
-        *num_lost_chunks += cur_stripe_lost_chunks_num;
-        cout << "placement === " << sum << endl;
+        (*num_failed_stripes) += GetStripeWeight(iter_stripe->first);
+        *num_lost_chunks += cur_stripe_lost_chunks_num * GetStripeWeight(iter_stripe->first);
+        if (logger_ != NULL) {
+          logger_->Log(Logger::kLogDebug, "placement === %d", sum);
+        }
         data_loss = true;
       }
     }
@@ -293,13 +599,15 @@ bool Placement::CheckDataLoss(map<int, vector<int> > stripe_disks_to_repair,
         }
       }
       if (stripe_failed_disks_num > code_m_) {
-        cout << "placement === " << stripe_failed_disks_num << endl;
-        for (iter_disk = stripe_failed_disks.begin(); iter_disk < stripe_failed_disks.end(); iter_disk++) {
-          cout << *iter_disk << " ";
+        if (logger_ != NULL && logger_->Enabled(Logger::kLogDebug)) {
+          string disks;
+          for (iter_disk = stripe_failed_disks.begin(); iter_disk < stripe_failed_disks.end(); iter_disk++) {
+            disks += to_string(*iter_disk) + " ";
+          }
+          logger_->Log(Logger::kLogDebug, "placement === %d: %s", stripe_failed_disks_num, disks.c_str());
         }
-        cout << endl;
-        (*num_failed_stripes) ++;
-        *num_lost_chunks += stripe_failed_disks_num;
+        (*num_failed_stripes) += GetStripeWeight(iter_stripe->first);
+        *num_lost_chunks += stripe_failed_disks_num * GetStripeWeight(iter_stripe->first);
         data_loss = true;
       }
     }
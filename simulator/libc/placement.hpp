@@ -1,3 +1,6 @@
+#ifndef SIMEDC_PLACEMENT_HPP_
+#define SIMEDC_PLACEMENT_HPP_
+
 #include <algorithm>
 #include <cstring>
 #include <iostream>
@@ -6,9 +9,45 @@
 #include <vector>
 #include <cstdlib>
 #include <map>
+#include <memory>
+#include <pthread.h>
 #include <set>
+#include <unordered_map>
+#include "logger.hpp"
+#include "strategy.hpp"
+#include "snapshot.hpp"
+#include "stripe_kernel.hpp"
+#include "thread_pool.hpp"
 using namespace std;
 
+struct HashDiskList {
+  size_t operator() (const vector<int> &disk_list) const;
+};
+
+// How a placement is generated, or the file it is loaded from.
+struct PlacementOptions {
+  // store stripes with the same disks once, with their number
+  bool compress;
+  int num_threads;
+  string place_type;
+  int scatter_width;
+  string load_fname;
+  // task pool of the owning simulation, used instead of num_threads
+  // threads when set
+  ThreadPool *pool;
+
+  PlacementOptions();
+};
+
+// Read-only run of ids stored in a placement, valid while the placement lives.
+struct IdRange {
+  const int *first;
+  const int *last;
+  const int *begin() const { return first; }
+  const int *end() const { return last; }
+  int size() const { return last - first; }
+};
+
 class Placement{
   private:
     int num_racks_, nodes_per_rack_, disks_per_node_, capacity_per_disk_;
@@ -18,11 +57,28 @@ class Placement{
 
     int code_l_;
 
-    vector<vector<int> > stripes_location_;
-    vector<vector<int> > stripes_per_disk_;
+    // stripe s is on the disks stripes_location_[s * code_n_, (s + 1) * code_n_)
+    vector<int> stripes_location_;
+    // the stripes of disk d are stripes_per_disk_[disk_offsets_[d], disk_offsets_[d + 1])
+    vector<int> stripes_per_disk_;
+    vector<long> disk_offsets_;
     vector<int> num_chunks_per_disk_;
+    // compressed placement: stripes_location_ holds the distinct disk sets
+    // (in chunk order for LRC, sorted otherwise) and stripe_weights_ the
+    // number of stripes placed on each of them
+    bool compress_;
+    vector<int> stripe_weights_;
+    unordered_map<vector<int>, int, HashDiskList> stripe_classes_;
+    long num_classes_;
+    PlacementOptions options_;
+    unsigned int seed_[2];
+    shared_ptr<PlacementStrategy> strategy_;
+    // a loaded placement file replaces the four arrays above
+    shared_ptr<Snapshot> snapshot_;
     int disks_per_rack_;
-    default_random_engine generator_;
+    // random engine of the owning simulation thread, used while generating
+    default_random_engine *generator_;
+    Logger *logger_;
 
   public:
     static const string kCodeTypeRS;
@@ -31,25 +87,67 @@ class Placement{
     static const string kCodeTypeReplication;
 
     static const string  kPlaceTypeFlat; //"Each chunk of a stripe resides in different rack"
+    static const string  kPlaceTypeCopyset;
+    static const string  kPlaceTypeRackGroup;
+    static const string  kPlaceTypeNode;
 
     static const int kLrcDataGroup[2][6];
     static const int kLrcLocalParity[2];
     static const int kLrcGlobalParity[2];
+    // stripes generated from one random stream
+    static const int kStripesPerBlock = 4096;
     Placement();
     Placement(int num_racks);
     Placement(int num_racks, int nodes_per_rack, int disks_per_node, 
               long capacity_per_disk, long num_stripes, int chunk_size, 
               string code_type, int code_n, int code_k,
-              int code_l, default_random_engine generator);
+              int code_l, default_random_engine *generator,
+              const PlacementOptions &options=PlacementOptions());
+    void SetLogger(Logger *logger);
     bool GeneratePlacement();
-    vector<int> GetDiffRacks(int num_diff_racks);
-    int GetDiskRandomly(int rack_id);
+    bool LoadPlacement(const string &fname);
+    bool Dump(const string &fname);
+    bool IsLoaded() { return snapshot_ != NULL; }
+    void GenerateBlocks(long first_block, long last_block);
     void GenerateNumChunksPerDisk();
+    // one task of GenerateNumChunksPerDisk() with a pool: positions[task]
+    // holds, for each disk, the stripes of the task's range and then the
+    // place of its first stripe among the stripes of the disk
+    void BuildDiskIndex(int step, int task, int num_tasks, vector<vector<int> > *positions);
     vector<int> GetStripesToRepair(int failed_disk_id);
     vector<int> GetStripeLocation(int stripe_id);
+    // the same without copies and checks
+    IdRange GetStripesOfDisk(int disk_id) {
+      const int *stripes = snapshot_ ? snapshot_->GetStripesPerDisk() : stripes_per_disk_.data();
+      const long *offsets = snapshot_ ? snapshot_->GetDiskOffsets() : disk_offsets_.data();
+      IdRange range = {stripes + offsets[disk_id], stripes + offsets[disk_id + 1]};
+      return range;
+    }
+    IdRange GetDisksOfStripe(int stripe_id) {
+      const int *location = snapshot_ ? snapshot_->GetLocation() : stripes_location_.data();
+      IdRange range = {location + (long)stripe_id * code_n_, 
+        location + (long)(stripe_id + 1) * code_n_};
+      return range;
+    }
+    int GetStripeWeight(int stripe_id) {
+      if (!compress_) return 1;
+      return snapshot_ ? snapshot_->GetWeights()[stripe_id] : stripe_weights_[stripe_id];
+    }
+    int GetNumStripeClasses() { return num_classes_; }
+    // chunks on the fullest disk, counting the stripes of a class
+    int GetMaxChunksPerDisk();
     bool CheckDataLoss(vector<int> failed_disks_list, int *num_failed_disks_list,
         int *num_lost_chunks);
     bool CheckDataLoss(map<int, vector<int> > stripe_disks_to_repair, 
         int *num_failed_disks_list, int *num_lost_chunks);
+    // only the given stripes, each once; disk_failed has a byte per disk as
+    // required by the kernel
+    bool CheckDataLoss(const vector<int> &stripes, const StripeKernel &kernel,
+        const unsigned char *disk_failed, int *num_failed_stripes, int *num_lost_chunks);
+    // failed chunks of an LRC stripe (bit i for chunk i) that the local
+    // parities cannot repair, data loss when more than code_n - code_k - code_l
+    int CountLrcUnrecoverable(unsigned long long failed);
 };
 
+
+#endif
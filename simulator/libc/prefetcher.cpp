@@ -0,0 +1,78 @@
+#include "prefetcher.hpp"
+#include <algorithm>
+
+TracePrefetcher::TracePrefetcher(const vector<int> &clusters, int depth, LoadFunc load,
+    void *args)
+  :clusters_(clusters), depth_(max(depth, 1)), load_(load), args_(args), done_(false),
+   stop_(false) {
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&ready_cond_, NULL);
+  pthread_cond_init(&space_cond_, NULL);
+  pthread_create(&thread_, NULL, Loader, this);
+}
+
+TracePrefetcher::~TracePrefetcher() {
+  pthread_mutex_lock(&mutex_);
+  stop_ = true;
+  pthread_cond_broadcast(&space_cond_);
+  pthread_mutex_unlock(&mutex_);
+  pthread_join(thread_, NULL);
+  pthread_cond_destroy(&ready_cond_);
+  pthread_cond_destroy(&space_cond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+void *TracePrefetcher::Loader(void *args) {
+  TracePrefetcher *prefetcher = (TracePrefetcher *)args;
+  for (size_t i = 0; i < prefetcher->clusters_.size(); i++) {
+    pthread_mutex_lock(&prefetcher->mutex_);
+    while (prefetcher->ready_.size() >= prefetcher->depth_ && !prefetcher->stop_) {
+      pthread_cond_wait(&prefetcher->space_cond_, &prefetcher->mutex_);
+    }
+    bool stop = prefetcher->stop_;
+    pthread_mutex_unlock(&prefetcher->mutex_);
+    if (stop) break;
+
+    ClusterTraces traces;
+    traces.cluster = prefetcher->clusters_[i];
+    prefetcher->load_(traces.cluster, prefetcher->args_, &traces.trace_lists);
+
+    pthread_mutex_lock(&prefetcher->mutex_);
+    prefetcher->ready_.push_back(ClusterTraces());
+    prefetcher->ready_.back().cluster = traces.cluster;
+    prefetcher->ready_.back().trace_lists.swap(traces.trace_lists);
+    pthread_cond_broadcast(&prefetcher->ready_cond_);
+    pthread_mutex_unlock(&prefetcher->mutex_);
+  }
+  pthread_mutex_lock(&prefetcher->mutex_);
+  prefetcher->done_ = true;
+  pthread_cond_broadcast(&prefetcher->ready_cond_);
+  pthread_mutex_unlock(&prefetcher->mutex_);
+  return 0;
+}
+
+bool TracePrefetcher::Get(int cluster, map<double, vector<FailedDisk> > *trace_lists) {
+  if (find(clusters_.begin(), clusters_.end(), cluster) == clusters_.end()) {
+    return false;
+  }
+  bool found = false;
+  pthread_mutex_lock(&mutex_);
+  while (true) {
+    // the clusters skipped by the caller
+    while (!ready_.empty() && ready_.front().cluster < cluster) {
+      ready_.pop_front();
+      pthread_cond_signal(&space_cond_);
+    }
+    if (!ready_.empty() && ready_.front().cluster == cluster) {
+      trace_lists->swap(ready_.front().trace_lists);
+      ready_.pop_front();
+      pthread_cond_signal(&space_cond_);
+      found = true;
+      break;
+    }
+    if (done_ || !ready_.empty()) break;
+    pthread_cond_wait(&ready_cond_, &mutex_);
+  }
+  pthread_mutex_unlock(&mutex_);
+  return found;
+}
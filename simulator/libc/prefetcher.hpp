@@ -0,0 +1,46 @@
+#ifndef SIMEDC_PREFETCHER_HPP_
+#define SIMEDC_PREFETCHER_HPP_
+
+#include <pthread.h>
+#include <deque>
+#include <map>
+#include <vector>
+#include "trace.hpp"
+using namespace std;
+
+// Traces of one cluster, by mission time.
+struct ClusterTraces {
+  int cluster;
+  map<double, vector<FailedDisk> > trace_lists;
+};
+
+// Loads the traces of a list of clusters, in order, on a thread of its own
+// while the previous clusters are simulated. At most depth clusters wait to
+// be taken; the loader runs outside of the lock.
+class TracePrefetcher {
+  public:
+    typedef void (*LoadFunc)(int cluster, void *args,
+        map<double, vector<FailedDisk> > *trace_lists);
+
+    TracePrefetcher(const vector<int> &clusters, int depth, LoadFunc load, void *args);
+    // stops loading, the clusters not taken are dropped
+    ~TracePrefetcher();
+    // move the traces of cluster into *trace_lists, waiting for them if
+    // needed, and drop the clusters before it; false if cluster is not in
+    // the list
+    bool Get(int cluster, map<double, vector<FailedDisk> > *trace_lists);
+
+  private:
+    vector<int> clusters_;
+    size_t depth_;
+    LoadFunc load_;
+    void *args_;
+    deque<ClusterTraces> ready_;
+    bool done_, stop_;
+    pthread_t thread_;
+    pthread_mutex_t mutex_;
+    pthread_cond_t ready_cond_, space_cond_;
+    static void *Loader(void *args);
+};
+
+#endif
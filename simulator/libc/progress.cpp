@@ -0,0 +1,157 @@
+#include "progress.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+// h:mm:ss
+static string FormatSeconds(double seconds) {
+  long s = (long)seconds;
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%ld:%02ld:%02ld", s / 3600, s / 60 % 60, s % 60);
+  return buffer;
+}
+
+ProgressReporter::ProgressReporter(double interval, const string &status_fname,
+    int num_threads)
+  :total_work_(0), done_work_(0), num_iterations_(0), num_threads_(max(num_threads, 1)),
+   interval_(interval), status_fname_(status_fname),
+   start_(chrono::steady_clock::now()), stop_(false) {
+  pthread_mutex_init(&mutex_, NULL);
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGUSR1);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+  pthread_create(&thread_, NULL, Reporter, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+  pthread_mutex_lock(&mutex_);
+  stop_ = true;
+  pthread_mutex_unlock(&mutex_);
+  // wakes the reporter
+  pthread_kill(thread_, SIGUSR1);
+  pthread_join(thread_, NULL);
+  Write(false);
+  pthread_mutex_destroy(&mutex_);
+}
+
+void *ProgressReporter::Reporter(void *args) {
+  ProgressReporter *reporter = (ProgressReporter *)args;
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGUSR1);
+  timespec timeout;
+  timeout.tv_sec = (time_t)reporter->interval_;
+  timeout.tv_nsec = (long)((reporter->interval_ - timeout.tv_sec) * 1e9);
+  while (true) {
+    int signal = reporter->interval_ > 0 ? sigtimedwait(&signals, NULL, &timeout) :
+      sigwaitinfo(&signals, NULL);
+    pthread_mutex_lock(&reporter->mutex_);
+    bool stop = reporter->stop_;
+    pthread_mutex_unlock(&reporter->mutex_);
+    if (stop) break;
+    if (signal == SIGUSR1 || (signal < 0 && errno == EAGAIN)) {
+      reporter->Write(true);
+    }
+  }
+  return 0;
+}
+
+void ProgressReporter::SetTotalWork(double work) {
+  pthread_mutex_lock(&mutex_);
+  total_work_ = work;
+  pthread_mutex_unlock(&mutex_);
+}
+
+int ProgressReporter::AddTask(const string &name, int cluster, int num_threads,
+    long num_iterations, double work) {
+  Task task;
+  task.name = name;
+  task.cluster = cluster;
+  task.num_threads = num_threads;
+  task.num_iterations = num_iterations;
+  task.work = work;
+  task.finished = false;
+  task.start = chrono::steady_clock::now();
+  pthread_mutex_lock(&mutex_);
+  tasks_.push_back(task);
+  int id = tasks_.size() - 1;
+  pthread_mutex_unlock(&mutex_);
+  return id;
+}
+
+void ProgressReporter::AddIteration(int task, bool data_loss) {
+  pthread_mutex_lock(&mutex_);
+  tasks_[task].data_loss.Add(data_loss);
+  done_work_ += tasks_[task].work;
+  num_iterations_ ++;
+  pthread_mutex_unlock(&mutex_);
+}
+
+void ProgressReporter::FinishTask(int task) {
+  pthread_mutex_lock(&mutex_);
+  tasks_[task].finished = true;
+  pthread_mutex_unlock(&mutex_);
+}
+
+string ProgressReporter::Format() {
+  chrono::steady_clock::time_point now = chrono::steady_clock::now();
+  double elapsed = chrono::duration<double>(now - start_).count();
+  char line[256];
+  stringstream s;
+  pthread_mutex_lock(&mutex_);
+  // a cluster is in flight until all its tasks are finished
+  set<int> clusters, in_flight;
+  for (size_t t = 0; t < tasks_.size(); t++) {
+    clusters.insert(tasks_[t].cluster);
+    if (!tasks_[t].finished) in_flight.insert(tasks_[t].cluster);
+  }
+  double rate = elapsed > 0 ? num_iterations_ / elapsed : 0;
+  snprintf(line, sizeof(line),
+      "[progress] %s elapsed, %d clusters finished, %d in flight, %lu iterations, "
+      "%.1f/s (%.2f/s per thread)", FormatSeconds(elapsed).c_str(),
+      (int)(clusters.size() - in_flight.size()), (int)in_flight.size(), num_iterations_,
+      rate, rate / num_threads_);
+  s << line;
+  if (total_work_ > 0 && done_work_ > 0) {
+    double done = min(done_work_ / total_work_, 1.0);
+    snprintf(line, sizeof(line), ", %.1f%% done, ETA %s", done * 100,
+        FormatSeconds(elapsed * (1 - done) / done).c_str());
+    s << line;
+  }
+  s << "\n";
+  for (size_t t = 0; t < tasks_.size(); t++) {
+    const Task &task = tasks_[t];
+    if (task.finished) continue;
+    double task_elapsed = chrono::duration<double>(now - task.start).count();
+    unsigned long done = task.data_loss.GetTrials();
+    snprintf(line, sizeof(line),
+        "  cluster %d %s: %lu/%ld iterations, %.2f/s per thread, PDL %.3e (RE %.1f%%)\n",
+        task.cluster, task.name.c_str(), done, task.num_iterations,
+        task_elapsed > 0 ? done / task_elapsed / task.num_threads : 0,
+        task.data_loss.GetMean(), task.data_loss.GetRelativeError(kZ95) * 100);
+    s << line;
+  }
+  pthread_mutex_unlock(&mutex_);
+  return s.str();
+}
+
+void ProgressReporter::Write(bool to_stderr) {
+  string report = Format();
+  if (to_stderr) {
+    cerr << report << flush;
+  }
+  if (status_fname_.empty()) return;
+  // replaced atomically, a monitor never reads half a report
+  string tmp_fname = status_fname_ + ".tmp";
+  ofstream outfile(tmp_fname, ofstream::out | ofstream::trunc);
+  outfile << report;
+  outfile.close();
+  if (outfile.fail() || rename(tmp_fname.c_str(), status_fname_.c_str()) != 0) {
+    cerr << "Fail to write status file " << status_fname_ << "!" << endl;
+  }
+}
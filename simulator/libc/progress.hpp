@@ -0,0 +1,58 @@
+#ifndef SIMEDC_PROGRESS_HPP_
+#define SIMEDC_PROGRESS_HPP_
+
+#include <pthread.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "estimator.hpp"
+using namespace std;
+
+// Progress of a sweep, reported by a thread of its own to stderr and to a
+// status file every interval seconds, and whenever the process gets SIGUSR1.
+// A task is one scenario on one cluster; its simulation threads count their
+// iterations here. The ETA weighs iterations by the work of their cluster
+// (CostModel::GetWork()).
+class ProgressReporter {
+  private:
+    struct Task {
+      string name;
+      int cluster;
+      int num_threads;
+      long num_iterations; // of all its threads
+      double work; // per iteration
+      ProportionStats data_loss;
+      bool finished;
+      chrono::steady_clock::time_point start;
+    };
+    vector<Task> tasks_;
+    double total_work_, done_work_;
+    unsigned long num_iterations_;
+    int num_threads_;
+    double interval_;
+    string status_fname_;
+    chrono::steady_clock::time_point start_;
+    bool stop_;
+    pthread_t thread_;
+    pthread_mutex_t mutex_;
+    static void *Reporter(void *args);
+    string Format();
+    void Write(bool to_stderr);
+
+  public:
+    // blocks SIGUSR1 in the calling thread, and so in the threads it creates
+    // afterwards, so that only the reporter takes it; interval 0 reports on
+    // SIGUSR1 only
+    ProgressReporter(double interval, const string &status_fname, int num_threads);
+    // the status file is written a last time
+    ~ProgressReporter();
+    // iterations * work of the whole sweep, for the ETA
+    void SetTotalWork(double work);
+    int AddTask(const string &name, int cluster, int num_threads, long num_iterations,
+        double work);
+    // one iteration of a thread of task
+    void AddIteration(int task, bool data_loss);
+    void FinishTask(int task);
+};
+
+#endif
@@ -0,0 +1,336 @@
+#include "result.hpp"
+
+// 95% confidence interval of PDL
+static void GetPdlInterval(string ci_method, const SimStats &stats, double *low, 
+    double *high) {
+  if (ci_method == "clopper-pearson") {
+    stats.data_loss.GetClopperPearsonInterval(0.05, low, high);
+  } else {
+    stats.data_loss.GetWilsonInterval(kZ95, low, high);
+  }
+}
+
+void PrintResult(string ci_method, const ClusterResult &result) {
+  const SimStats &stats = result.stats;
+  double pdl_low, pdl_high;
+  GetPdlInterval(ci_method, stats, &pdl_low, &pdl_high);
+  printf("PDL\t\tRE\t\tNOMDL\n");
+  printf("%.6f\t%.6f\t%e\n", stats.data_loss.GetMean(), 
+      stats.data_loss.GetRelativeError(kZ95), 
+      stats.lost_chunks.GetMean() / result.total_chunks);
+  printf("PDL 95%% CI (%s) = [%.6f, %.6f], NOMDL stderr = %e\n", ci_method.c_str(),
+      pdl_low, pdl_high, stats.lost_chunks.GetStdError() / result.total_chunks);
+  if (result.has_analytic) {
+    printf("PDL (analytic) = %.6f\n", result.analytic_pdl);
+  }
+}
+
+void WriteResult(string res_fname, string ci_method, bool header, 
+    const ClusterResult &result) {
+  const SimStats &stats = result.stats;
+  double avg_data_loss = stats.data_loss.GetMean();
+  double relative_error = stats.data_loss.GetRelativeError(kZ95);
+  double permanent_NOMDL = stats.lost_chunks.GetMean() / result.total_chunks;
+  double nomdl_stderr = stats.lost_chunks.GetStdError() / result.total_chunks;
+  double pdl_low, pdl_high;
+  GetPdlInterval(ci_method, stats, &pdl_low, &pdl_high);
+  ofstream outfile(res_fname, ofstream::app);
+  if (!outfile.fail()) {
+    if (header) {
+      outfile << "#disks/node,#nodes/rack,#racks,#total disks,#failures,";
+      outfile << "PDL,RE,NOMDL,PDL_low,PDL_high,NOMDL_stderr";
+      outfile << (result.has_analytic ? ",PDL_analytic\n" : "\n");
+    }
+    outfile << result.disks_per_node << "," << result.nodes_per_rack << ",";
+    outfile << result.num_racks << ",";
+    outfile << result.total_disks << "," << result.num_failures << ",";
+    outfile << fixed << setprecision(6) << avg_data_loss << "," << relative_error << ",";
+    outfile << scientific << permanent_NOMDL << ",";
+    outfile << fixed << setprecision(6) << pdl_low << "," << pdl_high << ",";
+    outfile << scientific << nomdl_stderr;
+    if (result.has_analytic) {
+      outfile << "," << result.analytic_pdl;
+    }
+    outfile << endl;
+    outfile.close();
+  }
+}
+
+static void WriteHistogramRow(ofstream &outfile, const ClusterResult &result,
+    string metric, const Histogram &histogram) {
+  outfile << result.disks_per_node << "," << result.nodes_per_rack << ",";
+  outfile << result.num_racks << "," << metric << "," << histogram.GetCount() << ",";
+  outfile << scientific << setprecision(6) << histogram.GetMean() << ",";
+  outfile << histogram.GetMin() << "," << histogram.GetQuantile(0.5) << ",";
+  outfile << histogram.GetQuantile(0.9) << "," << histogram.GetQuantile(0.99) << ",";
+  outfile << histogram.GetQuantile(0.999) << "," << histogram.GetMax() << ",";
+  outfile << histogram.FormatBuckets() << endl;
+}
+
+void WriteHistograms(string histogram_fname, bool header, const ClusterResult &result) {
+  const RepairHistograms &histograms = result.stats.histograms;
+  ofstream outfile(histogram_fname, ofstream::app);
+  if (!outfile.fail()) {
+    if (header) {
+      outfile << "#disks/node,#nodes/rack,#racks,metric,count,mean,min,";
+      outfile << "p50,p90,p99,p99.9,max,buckets\n";
+    }
+    WriteHistogramRow(outfile, result, "repair_hours", histograms.repair_hours);
+    WriteHistogramRow(outfile, result, "wait_hours", histograms.wait_hours);
+    WriteHistogramRow(outfile, result, "repair_traffic_mb", histograms.repair_traffic_mb);
+    for (size_t i = 1; i < histograms.degraded_hours.size(); i++) {
+      WriteHistogramRow(outfile, result, "degraded_hours_" + to_string(i),
+          histograms.degraded_hours[i]);
+    }
+    WriteHistogramRow(outfile, result, "data_loss_hours", histograms.data_loss_hours);
+    outfile.close();
+  }
+}
+
+static void WriteForegroundRow(ofstream &outfile, const ClusterResult &result,
+    double start, double end, double hours, double degraded_chunk_hours, 
+    double degraded_reads, double extra_mb) {
+  double fraction = hours > 0 ? degraded_chunk_hours / hours / result.total_chunks : 0;
+  outfile << result.disks_per_node << "," << result.nodes_per_rack << ",";
+  outfile << result.num_racks << ",";
+  outfile << fixed << setprecision(1) << start << "," << end << ",";
+  outfile << scientific << setprecision(6) << fraction << ",";
+  outfile << (hours > 0 ? degraded_reads / hours : 0) << ",";
+  outfile << (hours > 0 ? extra_mb / hours / 3600 : 0) << endl;
+}
+
+void PrintForeground(const ClusterResult &result) {
+  const ForegroundStats &foreground = result.stats.foreground;
+  double hours = 0, degraded_chunk_hours = 0, extra_mb = 0;
+  for (size_t bin = 0; bin < foreground.hours.size(); bin++) {
+    hours += foreground.hours[bin];
+    degraded_chunk_hours += foreground.degraded_chunk_hours[bin];
+    extra_mb += foreground.extra_mb[bin];
+  }
+  unsigned long num_iterations = result.stats.data_loss.GetTrials();
+  printf("Degraded reads: %.3e of reads, extra cross-rack traffic %.3e MB/s "
+      "(%.3e TB per iteration)\n", 
+      hours > 0 ? degraded_chunk_hours / hours / result.total_chunks : 0,
+      hours > 0 ? extra_mb / hours / 3600 : 0,
+      num_iterations > 0 ? extra_mb / num_iterations / 1e6 : 0);
+}
+
+void WriteForeground(string foreground_fname, bool header, double mission_time, 
+    int num_bins, const ClusterResult &result) {
+  const ForegroundStats &foreground = result.stats.foreground;
+  ofstream outfile(foreground_fname, ofstream::app);
+  if (!outfile.fail()) {
+    if (header) {
+      outfile << "#disks/node,#nodes/rack,#racks,start(hours),end(hours),";
+      outfile << "degraded_read_fraction,degraded_reads/hour,extra_cross_rack_MB/s\n";
+    }
+    double hours = 0, degraded_chunk_hours = 0, degraded_reads = 0, extra_mb = 0;
+    for (int bin = 0; bin < num_bins; bin++) {
+      // the iterations may all end, with data loss, before the last bins
+      if (bin >= (int)foreground.hours.size()) {
+        WriteForegroundRow(outfile, result, mission_time * bin / num_bins, 
+            mission_time * (bin + 1) / num_bins, 0, 0, 0, 0);
+        continue;
+      }
+      WriteForegroundRow(outfile, result, mission_time * bin / num_bins, 
+          mission_time * (bin + 1) / num_bins, foreground.hours[bin], 
+          foreground.degraded_chunk_hours[bin], foreground.degraded_reads[bin], 
+          foreground.extra_mb[bin]);
+      hours += foreground.hours[bin];
+      degraded_chunk_hours += foreground.degraded_chunk_hours[bin];
+      degraded_reads += foreground.degraded_reads[bin];
+      extra_mb += foreground.extra_mb[bin];
+    }
+    WriteForegroundRow(outfile, result, 0, mission_time, hours, degraded_chunk_hours, 
+        degraded_reads, extra_mb);
+    outfile.close();
+  }
+}
+
+void WriteAnalyticResult(string res_fname, bool header, const ClusterResult &result,
+    double stripe_mttdl) {
+  ofstream outfile(res_fname, ofstream::app);
+  if (!outfile.fail()) {
+    if (header) {
+      outfile << "#disks/node,#nodes/rack,#racks,#total disks,#failures,";
+      outfile << "stripe_MTTDL(hours),PDL_analytic\n";
+    }
+    outfile << result.disks_per_node << "," << result.nodes_per_rack << ",";
+    outfile << result.num_racks << ",";
+    outfile << result.total_disks << "," << result.num_failures << ",";
+    outfile << scientific << setprecision(6) << stripe_mttdl << "," << result.analytic_pdl << endl;
+    outfile.close();
+  }
+}
+
+void PrintPlacementBench(string place_type, string ci_method, const ClusterResult &result) {
+  const SimStats &stats = result.stats;
+  double pdl_low, pdl_high;
+  GetPdlInterval(ci_method, stats, &pdl_low, &pdl_high);
+  printf("%-10s %12.3f %10.6f [%.6f, %.6f] %e\n", place_type.c_str(),
+      stats.placement_seconds.GetMean() * 1000.0, stats.data_loss.GetMean(), 
+      pdl_low, pdl_high, stats.lost_chunks.GetMean() / result.total_chunks);
+}
+
+void WritePlacementBench(string bench_fname, string place_type, string ci_method,
+    bool header, const ClusterResult &result) {
+  const SimStats &stats = result.stats;
+  double pdl_low, pdl_high;
+  GetPdlInterval(ci_method, stats, &pdl_low, &pdl_high);
+  ofstream outfile(bench_fname, ofstream::app);
+  if (!outfile.fail()) {
+    if (header) {
+      outfile << "#disks/node,#nodes/rack,#racks,#total disks,#failures,place_type,";
+      outfile << "placement_ms,placement_ms_stderr,PDL,PDL_low,PDL_high,NOMDL\n";
+    }
+    outfile << result.disks_per_node << "," << result.nodes_per_rack << ",";
+    outfile << result.num_racks << ",";
+    outfile << result.total_disks << "," << result.num_failures << ",";
+    outfile << place_type << "," << fixed << setprecision(3);
+    outfile << stats.placement_seconds.GetMean() * 1000.0 << ",";
+    outfile << stats.placement_seconds.GetStdError() * 1000.0 << ",";
+    outfile << setprecision(6) << stats.data_loss.GetMean() << ",";
+    outfile << pdl_low << "," << pdl_high << ",";
+    outfile << scientific << stats.lost_chunks.GetMean() / result.total_chunks << endl;
+    outfile.close();
+  }
+}
+
+void PrintCrnResult(string policy, string baseline, const ClusterResult &result,
+    const PairedStats &paired) {
+  double pdl_diff = paired.data_loss_diff.GetMean();
+  double pdl_half = kZ95 * paired.data_loss_diff.GetStdError();
+  double nomdl_diff = paired.lost_chunks_diff.GetMean() / result.total_chunks;
+  double nomdl_half = kZ95 * paired.lost_chunks_diff.GetStdError() / result.total_chunks;
+  printf("%s - %s: PDL diff = %.6f [%.6f, %.6f], NOMDL diff = %e [%e, %e]\n",
+      policy.c_str(), baseline.c_str(), pdl_diff, pdl_diff - pdl_half, 
+      pdl_diff + pdl_half, nomdl_diff, nomdl_diff - nomdl_half, nomdl_diff + nomdl_half);
+}
+
+void WriteCrnResult(string crn_fname, bool header, string policy, string baseline,
+    const ClusterResult &result, const PairedStats &paired) {
+  double pdl_diff = paired.data_loss_diff.GetMean();
+  double pdl_half = kZ95 * paired.data_loss_diff.GetStdError();
+  double nomdl_diff = paired.lost_chunks_diff.GetMean() / result.total_chunks;
+  double nomdl_half = kZ95 * paired.lost_chunks_diff.GetStdError() / result.total_chunks;
+  ofstream outfile(crn_fname, ofstream::app);
+  if (!outfile.fail()) {
+    if (header) {
+      outfile << "#disks/node,#nodes/rack,#racks,#total disks,#failures,policy,baseline,";
+      outfile << "PDL_diff,PDL_diff_low,PDL_diff_high,NOMDL_diff,NOMDL_diff_low,NOMDL_diff_high\n";
+    }
+    outfile << result.disks_per_node << "," << result.nodes_per_rack << ",";
+    outfile << result.num_racks << ",";
+    outfile << result.total_disks << "," << result.num_failures << ",";
+    outfile << policy << "," << baseline << ",";
+    outfile << fixed << setprecision(6) << pdl_diff << "," << pdl_diff - pdl_half << ",";
+    outfile << pdl_diff + pdl_half << ",";
+    outfile << scientific << nomdl_diff << "," << nomdl_diff - nomdl_half << ",";
+    outfile << nomdl_diff + nomdl_half << endl;
+    outfile.close();
+  }
+}
+
+// Everything that must be equal for two runs to be merged; seed, 
+// iterations, output files and the keys that leave the results unchanged
+// (threads, stripe_kernel, danger_filter) may differ.
+string GetScenario(const Configure &configure) {
+  stringstream s;
+  s << setprecision(12);
+  s << "mission=" << configure.mission_time << ";chunk_size=" << configure.chunk_size;
+  s << ";capacity=" << configure.capacity_per_disk;
+  s << ";code=" << configure.code_type << "," << configure.code_n << "," << configure.code_k;
+  s << "," << configure.code_l << ";fail_dist=" << configure.disk_fail_dists.a() << ",";
+  s << configure.disk_fail_dists.b() << ";network=" << configure.use_network;
+  if (configure.network_setting != NULL) {
+    s << "," << configure.network_setting[0] << "," << configure.network_setting[1];
+  }
+  // the trace of each cluster is identified by its row
+  s << ";failure_trace=" << configure.use_failure_trace;
+  const SyntheticSetting &synthetic = configure.synthetic;
+  if (!synthetic.topologies.empty()) {
+    s << ";synthetic=" << synthetic.afr << "," << synthetic.burst_prob << ",";
+    s << synthetic.burst_size << "," << synthetic.burst_scope << "," << synthetic.burst_window;
+  }
+  s << ";lazy=" << configure.lazy_repair << "," << configure.lazy_repair_threshold;
+  s << ";placement=" << configure.place_type << "," << configure.scatter_width << ",";
+  s << configure.compress_placement << "," << configure.placement_load;
+  return s.str();
+}
+
+bool WriteStats(string stats_fname, string scenario, int seed, 
+    const ClusterResult &result) {
+  bool header = true;
+  ifstream infile(stats_fname, ifstream::in);
+  if (!infile.fail()) {
+    header = (infile.peek() == ifstream::traits_type::eof());
+    infile.close();
+  }
+  ofstream outfile(stats_fname, ofstream::app);
+  if (outfile.fail()) {
+    cout << "Fail to open stats file " << stats_fname << "!" << endl;
+    return false;
+  }
+  if (header) {
+    outfile << "# scenario=" << scenario << " seed=" << seed << "\n";
+    outfile << "#disks/node,#nodes/rack,#racks,#total disks,#failures,total_chunks,";
+    outfile << "iterations,data_loss,failed_stripes,lost_chunks,lost_chunks_sq\n";
+  }
+  const SimStats &stats = result.stats;
+  outfile << result.disks_per_node << "," << result.nodes_per_rack << ",";
+  outfile << result.num_racks << "," << result.total_disks << ",";
+  outfile << result.num_failures << "," << result.total_chunks << ",";
+  outfile << stats.data_loss.GetTrials() << "," << stats.data_loss.GetSuccesses() << ",";
+  outfile << stats.num_failed_stripes << "," << stats.sum_lost_chunks << ",";
+  outfile << stats.sum_sq_lost_chunks << "\n";
+  outfile.close();
+  return true;
+}
+
+bool ReadStats(string stats_fname, string *scenario, int *seed, 
+    vector<ClusterResult> *results) {
+  ifstream infile(stats_fname, ifstream::in);
+  if (infile.fail()) {
+    cout << "Fail to open stats file " << stats_fname << "!" << endl;
+    return false;
+  }
+  string line, word;
+  vector<string> row;
+  while (getline(infile, line)) {
+    if (line.empty()) continue;
+    if (line.compare(0, 11, "# scenario=") == 0) {
+      size_t pos = line.find(" seed=");
+      *scenario = line.substr(11, pos - 11);
+      *seed = stoi(line.substr(pos + 6));
+      continue;
+    }
+    if (line[0] == '#') continue;
+    stringstream s(line);
+    row.clear();
+    while (getline(s, word, ',')) {
+      row.push_back(word);
+    }
+    if (row.size() < 11) {
+      cout << "Wrong row in stats file " << stats_fname << ": " << line << endl;
+      return false;
+    }
+    ClusterResult result;
+    result.has_analytic = false;
+    result.disks_per_node = stoi(row[0]);
+    result.nodes_per_rack = stoi(row[1]);
+    result.num_racks = stoi(row[2]);
+    result.total_disks = stoi(row[3]);
+    result.num_failures = stoi(row[4]);
+    result.total_chunks = stoul(row[5]);
+    unsigned long iterations = stoul(row[6]);
+    result.stats.data_loss = ProportionStats(iterations, stoul(row[7]));
+    result.stats.num_failed_stripes = stoul(row[8]);
+    result.stats.sum_lost_chunks = stoul(row[9]);
+    result.stats.sum_sq_lost_chunks = stoul(row[10]);
+    result.stats.lost_chunks = RunningStats::FromSums(iterations, 
+        (double)result.stats.sum_lost_chunks, (double)result.stats.sum_sq_lost_chunks);
+    results->push_back(result);
+  }
+  infile.close();
+  return true;
+}
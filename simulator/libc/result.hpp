@@ -0,0 +1,70 @@
+#ifndef SIMEDC_RESULT_HPP_
+#define SIMEDC_RESULT_HPP_
+
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "parser.hpp"
+#include "estimator.hpp"
+using namespace std;
+
+// Topology of one cluster and the statistics of its iterations.
+struct ClusterResult {
+  int disks_per_node;
+  int nodes_per_rack;
+  int num_racks;
+  int total_disks;
+  int num_failures;
+  unsigned long total_chunks;
+  SimStats stats;
+  // PDL of the Markov model (--analytic), written next to the simulated one
+  bool has_analytic;
+  double analytic_pdl;
+};
+
+// Results CSV (PDL, RE, NOMDL, ...), one row per cluster.
+void PrintResult(string ci_method, const ClusterResult &result);
+void WriteResult(string res_fname, string ci_method, bool header, 
+    const ClusterResult &result);
+
+// Results of --analytic-only, one row per cluster.
+void WriteAnalyticResult(string res_fname, bool header, const ClusterResult &result,
+    double stripe_mttdl);
+
+// Placement generation time and PDL of one place_type (--bench-placement),
+// one row per cluster.
+void PrintPlacementBench(string place_type, string ci_method, const ClusterResult &result);
+void WritePlacementBench(string bench_fname, string place_type, string ci_method,
+    bool header, const ClusterResult &result);
+
+// Paired differences of a policy to the baseline policy in common-random-
+// numbers mode, one row per (cluster, policy) with 95% normal intervals.
+void PrintCrnResult(string policy, string baseline, const ClusterResult &result,
+    const PairedStats &paired);
+void WriteCrnResult(string crn_fname, bool header, string policy, string baseline,
+    const ClusterResult &result, const PairedStats &paired);
+
+// Repair histograms (histogram_fname), one row per cluster and metric with
+// its count, mean, quantiles and the "low:count" of its buckets.
+void WriteHistograms(string histogram_fname, bool header, const ClusterResult &result);
+
+// Foreground reads (read_rate), one row per cluster and interval of the
+// mission time and a last row for the whole mission.
+void PrintForeground(const ClusterResult &result);
+void WriteForeground(string foreground_fname, bool header, double mission_time, 
+    int num_bins, const ClusterResult &result);
+
+// Raw sufficient statistics, one row per cluster. Runs of the same scenario
+// with different seeds (shards) can be merged by simedc-merge. The file
+// starts with a comment line holding the scenario and the seed.
+string GetScenario(const Configure &configure);
+bool WriteStats(string stats_fname, string scenario, int seed, 
+    const ClusterResult &result);
+bool ReadStats(string stats_fname, string *scenario, int *seed, 
+    vector<ClusterResult> *results);
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef SIMEDC_H_
+#define SIMEDC_H_
+
+/*
+ * C API of the simulator, built as libsimedc.a and libsimedc.so. A
+ * simulation is created from a configuration, a cluster topology and an
+ * optional failure trace held in memory, runs iterations on a thread pool
+ * of the caller, and accumulates its results until it is reset or
+ * destroyed. No file is read or written.
+ *
+ * The structs only ever get new fields at their end, with the version
+ * raised; call simedc_config_init() before setting the fields.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIMEDC_API_VERSION 1
+
+typedef struct simedc_simulation simedc_simulation;
+
+/* any key of a configuration file, e.g., {"danger_filter", "0"} */
+typedef struct {
+  const char *key;
+  const char *value;
+} simedc_option;
+
+typedef struct {
+  int api_version; /* SIMEDC_API_VERSION */
+  double mission_time; /* hours */
+  int chunk_size; /* MB */
+  const char *code_type; /* "RSC", "LRC", "DRC" or "Rep" */
+  int code_n;
+  int code_k;
+  int code_l;
+  int lazy_repair;
+  int lazy_repair_threshold;
+  const char *place_type; /* "flat", "copyset", "rackgroup" or "node" */
+  int seed;
+  double network_bandwidth[2]; /* MB/s */
+  const simedc_option *options;
+  int num_options;
+} simedc_config;
+
+typedef struct {
+  int num_racks;
+  int nodes_per_rack;
+  int disks_per_node;
+} simedc_topology;
+
+/* a disk failure of the trace, disks numbered rack by rack and node by node */
+typedef struct {
+  int disk_id;
+  double fail_time; /* hours */
+} simedc_failure;
+
+/* Runs task(args[0]), ..., task(args[num_tasks - 1]), in parallel or not, and
+ * returns once all of them have returned. */
+typedef void (*simedc_task)(void *arg);
+typedef void (*simedc_run_tasks)(void *pool, simedc_task task, void **args, int num_tasks);
+
+typedef struct {
+  simedc_run_tasks run_tasks;
+  void *pool;
+  int num_threads; /* the iterations of a run are split into num_threads tasks */
+} simedc_executor;
+
+typedef struct {
+  /* accumulators, which can be summed over simulations */
+  unsigned long iterations;
+  unsigned long data_loss_iterations;
+  unsigned long sum_lost_chunks;
+  unsigned long sum_sq_lost_chunks;
+  unsigned long num_failed_stripes;
+  double total_chunks;
+  /* estimates */
+  double pdl;
+  double pdl_relative_error; /* of the 95% normal interval, 0 without data loss */
+  double pdl_low; /* 95% Wilson interval */
+  double pdl_high;
+  double nomdl;
+  double nomdl_stderr;
+} simedc_stats;
+
+int simedc_api_version(void);
+void simedc_config_init(simedc_config *config);
+/* with a trace of num_failures failures, or without (NULL) the failures are
+ * drawn from the disk failure distribution; NULL on a wrong configuration */
+simedc_simulation *simedc_create(const simedc_config *config, const simedc_topology *topology,
+    const simedc_failure *trace, int num_failures);
+void simedc_destroy(simedc_simulation *simulation);
+/* runs num_iterations more iterations, on the calling thread if executor is
+ * NULL; each task continues its own random stream from one run to the next,
+ * and a first run on n tasks draws the samples of the simedc binary run with
+ * processes=n; 0, or -1 on error */
+int simedc_run(simedc_simulation *simulation, long num_iterations,
+    const simedc_executor *executor);
+void simedc_get_stats(const simedc_simulation *simulation, simedc_stats *stats);
+/* clears the results, the random streams go on */
+void simedc_reset_stats(simedc_simulation *simulation);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,192 @@
+#include "simedc.h"
+#include "simulation.hpp"
+
+struct simedc_simulation {
+  Configure configure;
+  double network_setting[2];
+  vector<FailedDisk> trace;
+  // of each task, continued from one run to the next
+  vector<default_random_engine> generators;
+  SimStats stats;
+};
+
+// The iterations of one task of simedc_run().
+struct ApiTask {
+  simedc_simulation *simulation;
+  int index;
+  int num_iterations;
+  default_random_engine generator;
+  SimStats stats;
+  bool failed;
+};
+
+static void RunTask(void *args) {
+  ApiTask *task = (ApiTask *)args;
+  try {
+    Configure configure = task->simulation->configure;
+    configure.num_iterations = task->num_iterations;
+    configure.thread_id = task->index;
+    configure.generator = task->generator;
+    Simulation simulation(&configure);
+    simulation.Run(&task->stats);
+    task->generator = simulation.GetGenerator();
+  } catch (...) {
+    task->failed = true;
+  }
+}
+
+int simedc_api_version(void) {
+  return SIMEDC_API_VERSION;
+}
+
+void simedc_config_init(simedc_config *config) {
+  config->api_version = SIMEDC_API_VERSION;
+  config->mission_time = 87600;
+  config->chunk_size = 256;
+  config->code_type = "RSC";
+  config->code_n = 9;
+  config->code_k = 6;
+  config->code_l = 0;
+  config->lazy_repair = 0;
+  config->lazy_repair_threshold = 1;
+  config->place_type = "flat";
+  config->seed = 0;
+  config->network_bandwidth[0] = 125;
+  config->network_bandwidth[1] = 125;
+  config->options = NULL;
+  config->num_options = 0;
+}
+
+simedc_simulation *simedc_create(const simedc_config *config, const simedc_topology *topology,
+    const simedc_failure *trace, int num_failures) {
+  if (config == NULL || topology == NULL || config->api_version != SIMEDC_API_VERSION) {
+    cout << "simedc_create: wrong configuration or API version!" << endl;
+    return NULL;
+  }
+  // the keys of a configuration file, parsed as the simedc binary does
+  map<string, string> config_map;
+  config_map["processes"] = "1";
+  config_map["iterations"] = "1";
+  config_map["mission"] = to_string(config->mission_time);
+  config_map["chunk_size"] = to_string(config->chunk_size);
+  config_map["code_type"] = config->code_type == NULL ? "" : config->code_type;
+  config_map["code_n"] = to_string(config->code_n);
+  config_map["code_k"] = to_string(config->code_k);
+  config_map["code_l"] = to_string(config->code_l);
+  config_map["failure_trace"] = trace == NULL ? "0" : "1";
+  config_map["lazy_repair"] = to_string(config->lazy_repair);
+  config_map["lazy_th"] = to_string(config->lazy_repair_threshold);
+  config_map["seed"] = to_string(config->seed);
+  config_map["start_idx"] = "0";
+  config_map["end_idx"] = "0";
+  if (config->place_type != NULL) {
+    config_map["place_type"] = config->place_type;
+  }
+  for (int i = 0; i < config->num_options; i++) {
+    if (config->options[i].key != NULL && config->options[i].value != NULL) {
+      config_map[config->options[i].key] = config->options[i].value;
+    }
+  }
+
+  simedc_simulation *simulation = new simedc_simulation;
+  Configure &configure = simulation->configure;
+  try {
+    Parser::ParseConfiguration(config_map, &configure);
+  } catch (...) {
+    cout << "simedc_create: wrong configuration value!" << endl;
+    delete simulation;
+    return NULL;
+  }
+  if (configure.code_n < 1 || configure.code_n > StripeKernel::kMaxChunks ||
+      configure.code_k < 1 || configure.code_k > configure.code_n ||
+      topology->num_racks < configure.code_n || topology->nodes_per_rack < 1 ||
+      topology->disks_per_node < 1 || configure.chunk_size < 1) {
+    cout << "simedc_create: wrong code or topology!" << endl;
+    delete simulation;
+    return NULL;
+  }
+  Meta meta = {topology->num_racks, topology->nodes_per_rack, topology->disks_per_node,
+    topology->num_racks * topology->nodes_per_rack * topology->disks_per_node,
+    num_failures, 0};
+  Parser::SetCluster(&configure, meta);
+  for (int i = 0; trace != NULL && i < num_failures; i++) {
+    if (trace[i].disk_id < 0 || trace[i].disk_id >= meta.total_disks) {
+      cout << "simedc_create: disk " << trace[i].disk_id << " of the trace is not in the "
+        "topology!" << endl;
+      delete simulation;
+      return NULL;
+    }
+    FailedDisk failed_disk = {trace[i].disk_id, trace[i].fail_time};
+    simulation->trace.push_back(failed_disk);
+  }
+  simulation->network_setting[0] = config->network_bandwidth[0];
+  simulation->network_setting[1] = config->network_bandwidth[1];
+  configure.network_setting = simulation->network_setting;
+  configure.trace_list = &simulation->trace;
+  configure.trace_fname = "";
+  configure.num_processes = 1;
+  return simulation;
+}
+
+void simedc_destroy(simedc_simulation *simulation) {
+  delete simulation;
+}
+
+int simedc_run(simedc_simulation *simulation, long num_iterations,
+    const simedc_executor *executor) {
+  if (simulation == NULL || num_iterations < 0) return -1;
+  int num_tasks = executor == NULL ? 1 : max(executor->num_threads, 1);
+  // the streams of the simedc binary, seeded by (seed, thread)
+  while ((int)simulation->generators.size() < num_tasks) {
+    seed_seq seq = {simulation->configure.seed, (int)simulation->generators.size()};
+    simulation->generators.push_back(default_random_engine(seq));
+  }
+  vector<ApiTask> tasks(num_tasks);
+  vector<void *> args(num_tasks);
+  for (int i = 0; i < num_tasks; i++) {
+    tasks[i].simulation = simulation;
+    tasks[i].index = i;
+    tasks[i].num_iterations = num_iterations / num_tasks + (i < num_iterations % num_tasks);
+    tasks[i].generator = simulation->generators[i];
+    tasks[i].failed = false;
+    args[i] = &tasks[i];
+  }
+  if (executor == NULL || executor->run_tasks == NULL) {
+    for (int i = 0; i < num_tasks; i++) {
+      RunTask(args[i]);
+    }
+  } else {
+    executor->run_tasks(executor->pool, RunTask, &args[0], num_tasks);
+  }
+  // merged in task order, the results do not depend on the pool
+  bool failed = false;
+  for (int i = 0; i < num_tasks; i++) {
+    if (tasks[i].failed) {
+      failed = true;
+      continue;
+    }
+    simulation->generators[i] = tasks[i].generator;
+    simulation->stats.Merge(tasks[i].stats);
+  }
+  return failed ? -1 : 0;
+}
+
+void simedc_get_stats(const simedc_simulation *simulation, simedc_stats *stats) {
+  const SimStats &sim_stats = simulation->stats;
+  const Configure &configure = simulation->configure;
+  stats->iterations = sim_stats.data_loss.GetTrials();
+  stats->data_loss_iterations = sim_stats.data_loss.GetSuccesses();
+  stats->sum_lost_chunks = sim_stats.sum_lost_chunks;
+  stats->sum_sq_lost_chunks = sim_stats.sum_sq_lost_chunks;
+  stats->num_failed_stripes = sim_stats.num_failed_stripes;
+  stats->total_chunks = (double)configure.num_stripes * configure.code_n;
+  stats->pdl = sim_stats.data_loss.GetMean();
+  stats->pdl_relative_error = sim_stats.data_loss.GetRelativeError(kZ95);
+  sim_stats.data_loss.GetWilsonInterval(kZ95, &stats->pdl_low, &stats->pdl_high);
+  stats->nomdl = sim_stats.lost_chunks.GetMean() / stats->total_chunks;
+  stats->nomdl_stderr = sim_stats.lost_chunks.GetStdError() / stats->total_chunks;
+}
+
+void simedc_reset_stats(simedc_simulation *simulation) {
+  simulation->stats = SimStats();
+}
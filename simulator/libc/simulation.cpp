@@ -12,9 +12,40 @@ Simulation::Simulation(Configure *c)
    trace_fname_(c->trace_fname),
    lazy_repair_(c->lazy_repair), trace_list_(c->trace_list),
    lazy_repair_threshold_(c->lazy_repair_threshold), generator_(c->generator),
-   num_disks_(num_racks_ * nodes_per_rack_ * disks_per_node_){
+   num_disks_(num_racks_ * nodes_per_rack_ * disks_per_node_),
+   thread_id_(c->thread_id), logger_(c->log_level, c->thread_id),
+   event_trace_fname_(c->event_trace_fname), 
+   event_trace_iters_(c->event_trace_iters), trace_iteration_(false),
+   checkpoint_(c->checkpoint), checkpoint_interval_(c->checkpoint_interval),
+   progress_(c->progress), progress_task_(c->progress_task),
+   cluster_idx_(c->cluster_idx), first_iteration_(c->first_iteration),
+   placement_dump_(c->placement_dump), placement_dump_all_(c->placement_dump_all),
+   placement_seconds_(0),
+   record_histograms_(!c->histogram_fname.empty()), histograms_(NULL),
+   foreground_setting_(c->foreground), foreground_(NULL), chunk_read_rate_(0),
+   single_read_cost_(0), multi_read_cost_(0),
+   degraded_chunks_(0), degraded_read_cost_(0), foreground_time_(0),
+   crn_policies_(c->crn_policies), crn_(false), crn_seed_(0), lazy_counts_seen_(0),
+   lazy_burst_(0), num_lazy_bursts_(0) {
   network_setting_[0] = c->network_setting[0]; 
   network_setting_[1] = c->network_setting[1];
+  placement_options_.compress = c->compress_placement;
+  placement_options_.num_threads = c->placement_threads;
+  placement_options_.place_type = c->place_type;
+  placement_options_.scatter_width = c->scatter_width;
+  placement_options_.load_fname = c->placement_load;
+  danger_filter_ = c->danger_filter;
+  if (c->iteration_threads > 1) {
+    pool_.reset(new ThreadPool(c->iteration_threads));
+    placement_options_.pool = pool_.get();
+    // threads created by a pinned thread inherit its CPU, give them the
+    // CPUs of its node instead
+    if (NumaTopology::IsCurrentThreadPinned()) {
+      const NumaTopology &topology = NumaTopology::Get();
+      pool_->Pin(topology.GetNodeCpus(topology.GetCurrentNode()), false);
+    }
+  }
+  InitKernel(c->stripe_kernel);
 }
 
 Simulation::Simulation(int num_iterations, double mission_time, int num_racks, int nodes_per_rack,
@@ -37,13 +68,47 @@ Simulation::Simulation(int num_iterations, double mission_time, int num_racks, i
    trace_list_(trace_list), trace_fname_(trace_fname),
    lazy_repair_(lazy_repair), lazy_repair_threshold_(lazy_repair_threshold), 
    num_disks_(num_racks_ * nodes_per_rack_ * disks_per_node_),
-   generator_(generator) {
+   generator_(generator), thread_id_(0), event_trace_fname_(""),
+   trace_iteration_(false), checkpoint_(NULL), checkpoint_interval_(0),
+   progress_(NULL), progress_task_(-1), cluster_idx_(0), first_iteration_(0), 
+   placement_dump_all_(false), placement_seconds_(0), record_histograms_(false),
+   histograms_(NULL), foreground_(NULL), chunk_read_rate_(0), single_read_cost_(0),
+   multi_read_cost_(0), degraded_chunks_(0),
+   degraded_read_cost_(0), foreground_time_(0), crn_(false), crn_seed_(0), 
+   lazy_counts_seen_(0), lazy_burst_(0), num_lazy_bursts_(0) {
   network_setting_[0] = network_setting[0]; 
   network_setting_[1] = network_setting[1];
+  foreground_setting_.read_rate = 0;
+  danger_filter_ = true;
+  InitKernel(StripeKernel::kTypeAuto);
+}
+
+void Simulation::InitKernel(const string &kernel_type) {
+  kernel_.Select(kernel_type);
+  disk_rack_.resize(num_disks_);
+  for (int disk_id = 0; disk_id < num_disks_; disk_id++) {
+    disk_rack_[disk_id] = disk_id / (nodes_per_rack_ * disks_per_node_);
+  }
+}
+
+// Failed chunks a stripe tolerates; for LRC, those the local parities
+// cannot repair.
+int Simulation::GetMaxFailedChunks() {
+  if (strcmp(code_type_.c_str(), Placement::kCodeTypeLRC.c_str()) == 0) {
+    return code_n_ - code_k_ - code_l_;
+  }
+  return code_n_ - code_k_;
 }
 
 void Simulation::Reset() {
+  ResetState();
+  InitFailureEvents();
+  GeneratePlacement(&generator_);
+}
+
+void Simulation::ResetState() {
   state_ = State(num_disks_);
+  disks_.clear();
   if (use_failure_trace_) {
     for (int disk_id = 0; disk_id < num_disks_; disk_id ++) {
       Disk d = Disk();
@@ -64,6 +129,21 @@ void Simulation::Reset() {
   disk_stripes_in_repair_ = map<int, map<int, vector<int> > > ();
   stripe_disks_to_repair_ = map<int, vector<int> > ();
 
+  network_ = Network(num_racks_, nodes_per_rack_, network_setting_);
+  num_stripes_repaired_ = 0;
+  num_stripes_repaired_single_chunk_ = 0;
+  num_stripes_delayed_ = 0;
+  disk_fail_counts_.assign(num_disks_, 0);
+  ResetStripeFailures();
+  curr_time_ = 0;
+  degraded_chunks_ = 0;
+  degraded_read_cost_ = 0;
+  foreground_time_ = 0;
+  num_failure_events_ = 0;
+  num_repair_events_ = 0;
+}
+
+void Simulation::InitFailureEvents() {
   if (use_failure_trace_) {
     vector<FailedDisk>::iterator it;
     for (vector<FailedDisk>::iterator it = trace_list_->begin(); it < trace_list_->end(); it++) {
@@ -74,126 +154,228 @@ void Simulation::Reset() {
     }
   } else {
     for (int disk_id = 0; disk_id < num_disks_; disk_id++) {
-      double disk_fail_time = disk_fail_dists_(generator_);
+      double disk_fail_time = DrawDiskFailTime(disk_id);
       if (disk_fail_time <= mission_time_) {
         Event e = {disk_fail_time, Disk::kEventDiskFail, disk_id, 0};
         events_queue_.push(e);
       }
     }
   }
+}
+
+void Simulation::GeneratePlacement(default_random_engine *generator) {
+  // a loaded placement is used in every iteration
+  if (placement_.IsLoaded()) {
+    placement_seconds_ = 0.0;
+    return;
+  }
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
   placement_ = Placement(num_racks_, nodes_per_rack_, disks_per_node_, 
                          capacity_per_disk_, num_stripes_, chunk_size_, 
-                         code_type_, code_n_, code_k_, code_l_, generator_);
-  network_ = Network(num_racks_, nodes_per_rack_, network_setting_);
-  num_stripes_repaired_ = 0;
-  num_stripes_repaired_single_chunk_ = 0;
-  num_stripes_delayed_ = 0;
+                         code_type_, code_n_, code_k_, code_l_, generator,
+                         placement_options_);
+  placement_.SetLogger(&logger_);
+  ResetStripeFailures();
+  RepairCache empty = {false, 0.0, 0};
+  disk_repair_cache_.assign(num_disks_, empty);
+  placement_seconds_ = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  if (!placement_options_.load_fname.empty()) {
+    if (placement_.IsLoaded()) {
+      logger_.Log(Logger::kLogInfo, "placement: loaded %s", 
+          placement_options_.load_fname.c_str());
+    } else {
+      // generated instead, do not try again
+      placement_options_.load_fname = "";
+    }
+  }
+  if (placement_options_.compress) {
+    logger_.Log(Logger::kLogInfo, "placement: %d stripes in %d classes", num_stripes_,
+        placement_.GetNumStripeClasses());
+  }
+}
+
+// [placement_dump].c[cluster].i[iteration], iterations numbered as in the
+// event trace.
+void Simulation::DumpPlacement(int global_iter) {
+  string fname = placement_dump_ + ".c" + to_string(cluster_idx_) + ".i" + 
+    to_string(global_iter);
+  if (!placement_.Dump(fname)) {
+    cout << "Fail to dump the placement to " << fname << "!" << endl;
+    return;
+  }
+  logger_.Log(Logger::kLogInfo, "placement: dumped %s", fname.c_str());
+}
+
+// In CRN mode the k-th failure time of a disk only depends on the iteration
+// seed, the disk and k, so it is the same for all the policies.
+double Simulation::DrawDiskFailTime(int disk_idx) {
+  if (!crn_) {
+    return disk_fail_dists_(generator_);
+  }
+  unsigned long long x = crn_seed_ + 0x9E3779B97F4A7C15ULL * (disk_idx + 1) +
+    0xBF58476D1CE4E5B9ULL * (unsigned long long)disk_fail_counts_[disk_idx]++;
+  // splitmix64 finalizer
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  x = x ^ (x >> 31);
+  double u = (x >> 11) * (1.0 / 9007199254740992.0); // [0, 1)
+  return disk_fail_dists_.b() * pow(-log(1.0 - u), 1.0 / disk_fail_dists_.a());
 }
 
 void Simulation::SetDiskFail(int disk_idx, double curr_time) {
-  double disk_fail_time = disk_fail_dists_(generator_) + curr_time;
+  double disk_fail_time = DrawDiskFailTime(disk_idx) + curr_time;
   if (disk_fail_time <= mission_time_) {
     Event e = {disk_fail_time, Disk::kEventDiskFail, disk_idx, 0};
     events_queue_.push(e);
   }
 }
 
+void Simulation::ResetStripeFailures() {
+  stripe_failed_chunks_.assign(placement_.GetNumStripeClasses(), 0);
+  if (histograms_ != NULL) {
+    stripe_level_since_.assign(placement_.GetNumStripeClasses(), 0);
+  }
+  disk_shared_failures_.assign(num_disks_, 0);
+  disk_failed_.assign(num_disks_ + StripeKernel::kPadding, 0);
+  stripe_lazy_burst_.assign(placement_.GetNumStripeClasses(), 0);
+  lazy_burst_ = 0;
+  num_lazy_bursts_ = 0;
+}
+
+// delta is 1 when disk_idx fails and -1 when it is repaired, at curr_time.
+void Simulation::UpdateStripeFailures(int disk_idx, int delta, double curr_time) {
+  IdRange stripes = placement_.GetStripesOfDisk(disk_idx);
+  const int *iter_stripe;
+  if (foreground_ != NULL) {
+    // the reads until curr_time find the failed chunks of before
+    AddForegroundReads(curr_time);
+    for (iter_stripe = stripes.begin(); iter_stripe < stripes.end(); iter_stripe++) {
+      AddDegradedStripe(*iter_stripe, -1);
+    }
+  }
+  disk_failed_[disk_idx] = delta > 0 ? 1 : 0;
+  for (iter_stripe = stripes.begin(); iter_stripe < stripes.end(); iter_stripe++) {
+    int before = stripe_failed_chunks_[*iter_stripe];
+    int after = before + delta;
+    stripe_failed_chunks_[*iter_stripe] = after;
+    if (histograms_ != NULL) {
+      // the stripe leaves the level where it has been since stripe_level_since_
+      if (before > 0) {
+        histograms_->AddDegraded(before, curr_time - stripe_level_since_[*iter_stripe],
+            placement_.GetStripeWeight(*iter_stripe));
+      }
+      stripe_level_since_[*iter_stripe] = curr_time;
+    }
+    if ((before > 1) == (after > 1)) continue;
+    // the stripe starts or stops having several failed chunks
+    IdRange disks = placement_.GetDisksOfStripe(*iter_stripe);
+    for (const int *iter_disk = disks.begin(); iter_disk < disks.end(); iter_disk++) {
+      disk_shared_failures_[*iter_disk] += after > 1 ? 1 : -1;
+    }
+  }
+  if (foreground_ != NULL) {
+    for (iter_stripe = stripes.begin(); iter_stripe < stripes.end(); iter_stripe++) {
+      AddDegradedStripe(*iter_stripe, 1);
+    }
+  }
+}
+
+void Simulation::RebuildStripeFailures() {
+  ResetStripeFailures();
+  for (int disk_id = 0; disk_id < num_disks_; disk_id++) {
+    if (strcmp(disks_[disk_id].GetCurrState().c_str(), Disk::kStateCrashed.c_str()) == 0) {
+      UpdateStripeFailures(disk_id, 1, curr_time_);
+    }
+  }
+}
+
+// The stripes still degraded when an iteration ends count until end_time.
+void Simulation::CloseDegradedPeriods(double end_time) {
+  for (size_t stripe = 0; stripe < stripe_failed_chunks_.size(); stripe++) {
+    if (stripe_failed_chunks_[stripe] > 0) {
+      histograms_->AddDegraded(stripe_failed_chunks_[stripe],
+          end_time - stripe_level_since_[stripe], placement_.GetStripeWeight(stripe));
+    }
+  }
+}
+
+// Eager repair ends the iteration at the first data loss, so only the stripes
+// of the disks failed by the last event group can be lost, and only if they
+// have enough failed chunks. Each of those stripes is evaluated once.
+bool Simulation::CheckBurstDataLoss(const vector<int> &disk_id_set, int *num_failed_stripes,
+    int *num_lost_chunks) {
+  int max_failed_chunks = GetMaxFailedChunks();
+  burst_stripes_.clear();
+  vector<int>::const_iterator iter_disk;
+  for (iter_disk = disk_id_set.begin(); iter_disk < disk_id_set.end(); iter_disk++) {
+    IdRange stripes = placement_.GetStripesOfDisk(*iter_disk);
+    for (const int *iter_stripe = stripes.begin(); iter_stripe < stripes.end(); iter_stripe++) {
+      if (stripe_failed_chunks_[*iter_stripe] > max_failed_chunks) {
+        burst_stripes_.push_back(*iter_stripe);
+      }
+    }
+  }
+  sort(burst_stripes_.begin(), burst_stripes_.end());
+  burst_stripes_.erase(unique(burst_stripes_.begin(), burst_stripes_.end()), 
+      burst_stripes_.end());
+  return placement_.CheckDataLoss(burst_stripes_, kernel_, disk_failed_.data(), 
+      num_failed_stripes, num_lost_chunks);
+}
+
 void Simulation::SetDiskRepair(int disk_idx, double curr_time) {
-  int rack_id = (int) (disk_idx / (nodes_per_rack_ * disks_per_node_));
   if (network_.GetAvailCrossRackRepairBwth() == 0) {
     Event e = {curr_time, "", disk_idx, 0};
     wait_repair_queue_.push(e);
   } else { // available cross rack repair bwth > 0
     double cross_rack_download = 0;
-    vector<int> stripes_to_repair = placement_.GetStripesToRepair(disk_idx);
+    IdRange stripes_to_repair = placement_.GetStripesOfDisk(disk_idx);
     int num_stripes_repaired_actual = 0;
+    bool crashed = strcmp(disks_[disk_idx].GetCurrState().c_str(), 
+        Disk::kStateCrashed.c_str()) == 0;
+    // each stripe of the disk has only this failed chunk: the traffic only
+    // depends on the placement, take it from the cache once computed
+    bool only_failure = crashed && disk_shared_failures_[disk_idx] == 0;
+    RepairCache &cache = disk_repair_cache_[disk_idx];
+    if (only_failure && cache.valid) {
+      cross_rack_download = cache.cross_rack_download;
+      num_stripes_repaired_actual = cache.num_stripes;
+      num_stripes_repaired_single_chunk_ += cache.num_stripes;
+      stripes_to_repair.last = stripes_to_repair.first;
+    }
 
-    vector<int>::iterator iter_stripe;
-    for (iter_stripe = stripes_to_repair.begin(); 
-        iter_stripe < stripes_to_repair.end(); iter_stripe++) {
-      int num_failed_chunk = 0;
-      int num_alive_chunk_same_rack = 0;
-      int idx = 0;
-      int fail_idx = 0;
-      int global_failed_disks_num = 0;
-      int stripe_failed_disks_num[2] = {0};
-      vector<int> alive_chunk_same_rack;
-      
-      vector<int> disks_attached = placement_.GetStripeLocation(*iter_stripe);
-      vector<int>::iterator iter_disk;
-      for (iter_disk = disks_attached.begin(); 
-          iter_disk < disks_attached.end(); iter_disk++) {
-        // RS, DRC, replication
-        if (strcmp(code_type_.c_str(), Placement::kCodeTypeLRC.c_str()) != 0) {
-          if (strcmp(disks_[*iter_disk].GetCurrState().c_str(), Disk::kStateCrashed.c_str()) == 0) 
-            num_failed_chunk ++;
-          else {
-            if ((int)(*iter_disk / (nodes_per_rack_ * disks_per_node_)) == rack_id) {
-              num_alive_chunk_same_rack ++;
-            }
-          }
-        } else { // LRC
-          if (strcmp(disks_[*iter_disk].GetCurrState().c_str(), Disk::kStateCrashed.c_str()) == 0) {
-            num_failed_chunk ++;
-            if (disk_idx == *iter_disk) fail_idx = idx;
-            // check position of failed disk
-            if (idx == Placement::kLrcGlobalParity[0] || idx == Placement::kLrcGlobalParity[1]) {
-              // global parity
-              global_failed_disks_num ++;
-            } else {
-              if (idx != Placement::kLrcLocalParity[0] && idx != Placement::kLrcLocalParity[1]) {
-                // data group
-                for (int gid = 0; gid < code_l_; gid++) {
-                  const int *p = find(begin(Placement::kLrcDataGroup[gid]), end(Placement::kLrcDataGroup[gid]), idx);
-                  if (p != end(Placement::kLrcDataGroup[gid])) {
-                    stripe_failed_disks_num[gid] ++;
-                    break;
-                  }
-                }
-              }
-            }
-          } else {
-            // *iter_disk is alive
-            // check local parity
-            for (int gid = 0; gid < code_l_; gid++) {
-              if (idx == Placement::kLrcLocalParity[gid] && stripe_failed_disks_num[gid] > 0){
-                stripe_failed_disks_num[gid] --;
-                break;
-              }
-            }
-            if ((int)(*iter_disk / (nodes_per_rack_ * disks_per_node_)) == rack_id) {
-              num_alive_chunk_same_rack ++;
-              alive_chunk_same_rack.push_back(idx);
-            }
-          }
-          idx ++;
-        }
+    // the traffic of a stripe is a whole number of chunks, so the sums of
+    // the tasks add up to the same traffic as one scan
+    int num_tasks = GetNumScanTasks(stripes_to_repair.size());
+    repair_scans_.resize(max(num_tasks, 1));
+    for (int i = 0; i < (int)repair_scans_.size(); i++) {
+      RepairScan scan = {this, 
+        stripes_to_repair.begin() + (long)stripes_to_repair.size() * i / repair_scans_.size(),
+        stripes_to_repair.begin() + (long)stripes_to_repair.size() * (i + 1) / repair_scans_.size(),
+        disk_idx, 0, 0, 0, -1};
+      repair_scans_[i] = scan;
+      if (num_tasks > 1) {
+        pool_->Submit(RunRepairScan, &repair_scans_[i]);
+      } else {
+        ScanRepairStripes(&repair_scans_[i]);
       }
-      if (num_failed_chunk == 1)  // single chunk repair
-        num_stripes_repaired_single_chunk_ ++;
-      else {
-        // Check correlated failures
-        if (strcmp(code_type_.c_str(), Placement::kCodeTypeLRC.c_str()) == 0) {
-          int sum = global_failed_disks_num;
-          for (int gid = 0; gid < code_l_; gid++) {
-            sum += stripe_failed_disks_num[gid];
-          }
-          if (sum > code_n_ - code_k_ - code_l_) {
-            cout << "data loss" << endl;
-            return;
-          }
-        } else {
-          if (num_failed_chunk > code_n_ - code_k_) {
-            cout << "data loss" << endl;
-            return;
-          }
-        }
+    }
+    if (num_tasks > 1) pool_->Wait();
+    vector<RepairScan>::iterator iter_scan;
+    for (iter_scan = repair_scans_.begin(); iter_scan < repair_scans_.end(); iter_scan++) {
+      num_stripes_repaired_single_chunk_ += iter_scan->num_stripes_single_chunk;
+      if (iter_scan->loss_stripe >= 0) {
+        logger_.Log(Logger::kLogDebug, "data loss: disk %d, stripe %d", disk_idx, 
+            iter_scan->loss_stripe);
+        return;
       }
-
-      num_stripes_repaired_actual ++;
-      cross_rack_download += ComputeRepairTrafficForStripe(num_failed_chunk, 
-          num_alive_chunk_same_rack, alive_chunk_same_rack, fail_idx);
-    } // end of looping stripe
+      num_stripes_repaired_actual += iter_scan->num_stripes;
+      cross_rack_download += iter_scan->cross_rack_download;
+    }
+    if (only_failure && !cache.valid) {
+      cache.valid = true;
+      cache.cross_rack_download = cross_rack_download;
+      cache.num_stripes = num_stripes_repaired_actual;
+    }
     num_stripes_repaired_ += num_stripes_repaired_actual;
     // Not consider cross rack upload for eager repair with multiple bad chunks since other disks may be still failed.
     double repair_bwth = network_.GetAvailCrossRackRepairBwth();
@@ -201,9 +383,98 @@ void Simulation::SetDiskRepair(int disk_idx, double curr_time) {
     double repair_time = cross_rack_download * chunk_size_ / repair_bwth / 3600.0; // hours
     Event e = {repair_time + curr_time, Disk::kEventDiskRepair, disk_idx, repair_bwth};
     events_queue_.push(e);
+    if (histograms_ != NULL) {
+      histograms_->repair_hours.Add(repair_time);
+      histograms_->repair_traffic_mb.Add(cross_rack_download * chunk_size_);
+    }
   }
 }
 
+// Tasks of the pool that scan num_stripes stripes, 0 to scan them in the
+// calling thread.
+int Simulation::GetNumScanTasks(int num_stripes) {
+  if (pool_ == NULL) return 0;
+  int num_tasks = min(pool_->GetNumThreads(), num_stripes / kStripesPerTask);
+  return num_tasks > 1 ? num_tasks : 0;
+}
+
+// Traffic of the stripes of a scan, until the first stripe that loses data.
+void Simulation::ScanRepairStripes(RepairScan *scan) {
+  int disk_idx = scan->disk_idx;
+  int rack_id = disk_rack_[disk_idx];
+  bool is_lrc = strcmp(code_type_.c_str(), Placement::kCodeTypeLRC.c_str()) == 0;
+  int max_failed_chunks = GetMaxFailedChunks();
+  vector<int> alive_chunk_same_rack;
+  const int *iter_stripe;
+  for (iter_stripe = scan->first; iter_stripe < scan->last; iter_stripe++) {
+    IdRange disks_attached = placement_.GetDisksOfStripe(*iter_stripe);
+    StripeMasks masks = kernel_.Evaluate(disks_attached.begin(), code_n_, 
+        disk_failed_.data(), disk_rack_.data(), disk_idx, rack_id);
+    int num_failed_chunk = __builtin_popcountll(masks.failed);
+    int num_alive_chunk_same_rack = __builtin_popcountll(masks.same_rack_alive);
+    int fail_idx = 0;
+    if (is_lrc) {
+      if (masks.failed & masks.repaired) fail_idx = __builtin_ctzll(masks.failed & masks.repaired);
+      GetChunkIndices(masks.same_rack_alive, &alive_chunk_same_rack);
+    }
+    if (num_failed_chunk == 1)  // single chunk repair
+      scan->num_stripes_single_chunk += placement_.GetStripeWeight(*iter_stripe);
+    else {
+      // Check correlated failures
+      int num_lost_chunks = is_lrc ? placement_.CountLrcUnrecoverable(masks.failed) : 
+        num_failed_chunk;
+      if (num_lost_chunks > max_failed_chunks) {
+        scan->loss_stripe = *iter_stripe;
+        return;
+      }
+    }
+
+    scan->num_stripes += placement_.GetStripeWeight(*iter_stripe);
+    scan->cross_rack_download += placement_.GetStripeWeight(*iter_stripe) *
+      ComputeRepairTrafficForStripe(num_failed_chunk, num_alive_chunk_same_rack,
+          alive_chunk_same_rack, fail_idx);
+  } // end of looping stripe
+}
+
+void *Simulation::RunRepairScan(void *args) {
+  RepairScan *scan = (RepairScan *)args;
+  scan->simulation->ScanRepairStripes(scan);
+  return 0;
+}
+
+// Kernel results of many stripes of a disk, evaluated by the tasks of the
+// pool into stripe_masks_ (in the order of stripes); false if there are too
+// few stripes to split, the caller evaluates them then.
+bool Simulation::EvaluateStripes(IdRange stripes, int disk_idx) {
+  int num_tasks = GetNumScanTasks(stripes.size());
+  if (num_tasks == 0) return false;
+  stripe_masks_.resize(stripes.size());
+  mask_scans_.resize(num_tasks);
+  for (int i = 0; i < num_tasks; i++) {
+    long first = (long)stripes.size() * i / num_tasks;
+    MaskScan scan = {this, stripes.begin() + first, 
+      stripes.begin() + (long)stripes.size() * (i + 1) / num_tasks, disk_idx, 
+      stripe_masks_.data() + first};
+    mask_scans_[i] = scan;
+    pool_->Submit(RunMaskScan, &mask_scans_[i]);
+  }
+  pool_->Wait();
+  return true;
+}
+
+void *Simulation::RunMaskScan(void *args) {
+  MaskScan *scan = (MaskScan *)args;
+  Simulation *simulation = scan->simulation;
+  int rack_id = simulation->disk_rack_[scan->disk_idx];
+  StripeMasks *masks = scan->masks;
+  for (const int *iter_stripe = scan->first; iter_stripe < scan->last; iter_stripe++) {
+    IdRange disks_attached = simulation->placement_.GetDisksOfStripe(*iter_stripe);
+    *masks++ = simulation->kernel_.Evaluate(disks_attached.begin(), simulation->code_n_,
+        simulation->disk_failed_.data(), simulation->disk_rack_.data(), scan->disk_idx, rack_id);
+  }
+  return 0;
+}
+
 int Simulation::CheckStripeDisksToRepair(int stripe_id) {
   map<int, vector<int> >::iterator it_key;
   it_key = stripe_disks_to_repair_.find(stripe_id);
@@ -234,134 +505,87 @@ void Simulation::SetDiskLazyRepair(int disk_idx, double curr_time){
     wait_repair_queue_.push(e);
   } else { // available cross rack repair bwth > 0
     double cross_rack_download = 0;
-    vector<int> stripes_to_repair = placement_.GetStripesToRepair(disk_idx);
+    IdRange stripes_to_repair = placement_.GetStripesOfDisk(disk_idx);
     int num_stripes_repaired_actual = 0;
     // record disks and their attached stripes that will be repaired following disk_idx
     map<int, vector<int> > map_disk_stripes_in_repair; 
+    bool is_lrc = strcmp(code_type_.c_str(), Placement::kCodeTypeLRC.c_str()) == 0;
+    int max_failed_chunks = GetMaxFailedChunks();
+    vector<int> alive_chunk_same_rack, chunks;
+    // the failed disks do not change while the stripes are repaired
+    bool evaluated = EvaluateStripes(stripes_to_repair, disk_idx);
 
-    vector<int>::iterator iter_stripe;
+    const int *iter_stripe;
     for (iter_stripe = stripes_to_repair.begin(); 
         iter_stripe < stripes_to_repair.end(); iter_stripe++) {
-      int num_failed_chunk = 0;
-      int num_alive_chunk_same_rack = 0;
-      int idx = 0;
-      int fail_idx = 0;
-      int global_failed_disks_num = 0;
-      int stripe_failed_disks_num[2] = {0};
-      vector<int> alive_chunk_same_rack;
+      // another disk of the group already left this stripe for later, with 
+      // the same failed chunks
+      if (lazy_burst_ != 0 && stripe_lazy_burst_[*iter_stripe] == lazy_burst_) continue;
       vector<int> disks_to_repair; // find the disks that need to repaired in one stripe
 
-      vector<int> disks_attached = placement_.GetStripeLocation(*iter_stripe);
-      vector<int>::iterator iter_disk;
-      for (iter_disk = disks_attached.begin(); 
-          iter_disk < disks_attached.end(); iter_disk++) {
-        // RS, DRC, replication
-        if (strcmp(code_type_.c_str(), Placement::kCodeTypeLRC.c_str()) != 0) {
-          if (strcmp(disks_[*iter_disk].GetCurrState().c_str(), Disk::kStateCrashed.c_str()) == 0 ||
-              CheckStripeDisksToRepair(*iter_stripe, *iter_disk) == 2) {
-            num_failed_chunk ++;
-            disks_to_repair.push_back(*iter_disk);
-          } else {
-            if ((int)(*iter_disk / (nodes_per_rack_ * disks_per_node_)) == rack_id) {
-              num_alive_chunk_same_rack ++;
-            }
-          }
-        } else { // LRC
-          if (strcmp(disks_[*iter_disk].GetCurrState().c_str(), Disk::kStateCrashed.c_str()) == 0 ||
-              CheckStripeDisksToRepair(*iter_stripe, *iter_disk) == 2) { // *iter_disk is failed
-            num_failed_chunk ++;
-            disks_to_repair.push_back(*iter_disk);
-            if (disk_idx == *iter_disk) fail_idx = idx;
-            // check position of failed disk
-            if (idx == Placement::kLrcGlobalParity[0] || idx == Placement::kLrcGlobalParity[1]) {
-              // global parity
-              global_failed_disks_num ++;
-            } else {
-              if (idx != Placement::kLrcLocalParity[0] && idx != Placement::kLrcLocalParity[1]) {
-                // data group
-                for (int gid = 0; gid < code_l_; gid++) {
-                  const int *p = find(begin(Placement::kLrcDataGroup[gid]), end(Placement::kLrcDataGroup[gid]), idx);
-                  if (p != end(Placement::kLrcDataGroup[gid])) {
-                    stripe_failed_disks_num[gid] ++;
-                    break;
-                  }
-                }
-              }
-            }
-          } else {
-            // *iter_disk is alive
-            // check local parity
-            for (int gid = 0; gid < code_l_; gid++) {
-              if (idx == Placement::kLrcLocalParity[gid] && stripe_failed_disks_num[gid] > 0){
-                stripe_failed_disks_num[gid] --;
-                break;
-              }
-            }
-            if ((int)(*iter_disk / (nodes_per_rack_ * disks_per_node_)) == rack_id) {
-              num_alive_chunk_same_rack ++;
-              alive_chunk_same_rack.push_back(idx);
-            }
+      IdRange disks_attached = placement_.GetDisksOfStripe(*iter_stripe);
+      StripeMasks masks = evaluated ? stripe_masks_[iter_stripe - stripes_to_repair.begin()] :
+        kernel_.Evaluate(disks_attached.begin(), code_n_, disk_failed_.data(), 
+            disk_rack_.data(), disk_idx, rack_id);
+      // the chunks left for a later repair are failed as well
+      unsigned long long failed = masks.failed;
+      map<int, vector<int> >::iterator it_pending = stripe_disks_to_repair_.find(*iter_stripe);
+      if (it_pending != stripe_disks_to_repair_.end()) {
+        for (int idx = 0; idx < code_n_; idx++) {
+          if (find(it_pending->second.begin(), it_pending->second.end(), 
+                disks_attached.begin()[idx]) != it_pending->second.end()) {
+            failed |= 1ULL << idx;
           }
-          idx ++;
         }
-      } // end of looping disks on this stripe
+      }
+      unsigned long long same_rack_alive = masks.same_rack_alive & ~failed;
+      int num_failed_chunk = __builtin_popcountll(failed);
+      int num_alive_chunk_same_rack = __builtin_popcountll(same_rack_alive);
+      int fail_idx = 0;
+      GetChunkIndices(failed, &chunks);
+      for (vector<int>::iterator it = chunks.begin(); it < chunks.end(); it++) {
+        disks_to_repair.push_back(disks_attached.begin()[*it]);
+      }
+      if (is_lrc) {
+        if (failed & masks.repaired) fail_idx = __builtin_ctzll(failed & masks.repaired);
+        GetChunkIndices(same_rack_alive, &alive_chunk_same_rack);
+      }
       // Check tolerable limit
-      if (strcmp(code_type_.c_str(), Placement::kCodeTypeLRC.c_str()) == 0) {
-        int sum = global_failed_disks_num;
-        for (int gid = 0; gid < code_l_; gid++) {
-          sum += stripe_failed_disks_num[gid];
-        }
-        if (sum > code_n_ - code_k_ - code_l_) {
-          cout << "data loss" << endl;
-          if (CheckStripeDisksToRepair(*iter_stripe) == 1) {
-            //cout << "Current disk_idx = " << disk_idx << ", current stripe = " << *iter_stripe << endl;
-            for (iter_disk = disks_to_repair.begin(); iter_disk < disks_to_repair.end(); iter_disk++) {
-              if (find(stripe_disks_to_repair_[*iter_stripe].begin(), 
-                    stripe_disks_to_repair_[*iter_stripe].end(), *iter_disk) == 
-                  stripe_disks_to_repair_[*iter_stripe].end()) {
-                // this disk is not in stripe_disks_to_repair_[*iter_stripe]
-                stripe_disks_to_repair_[*iter_stripe].push_back(*iter_disk);
-              }
+      int num_lost_chunks = is_lrc ? placement_.CountLrcUnrecoverable(failed) : num_failed_chunk;
+      if (num_lost_chunks > max_failed_chunks) {
+        logger_.Log(Logger::kLogDebug, "data loss: disk %d, stripe %d", disk_idx, *iter_stripe);
+        if (it_pending != stripe_disks_to_repair_.end()) {
+          //cout << "Current disk_idx = " << disk_idx << ", current stripe = " << *iter_stripe << endl;
+          vector<int>::iterator iter_repair;
+          for (iter_repair = disks_to_repair.begin(); iter_repair < disks_to_repair.end(); iter_repair++) {
+            if (find(it_pending->second.begin(), it_pending->second.end(), *iter_repair) == 
+                it_pending->second.end()) {
+              // this disk is not in stripe_disks_to_repair_[*iter_stripe]
+              it_pending->second.push_back(*iter_repair);
             }
-          } else {
-            stripe_disks_to_repair_[*iter_stripe] = disks_to_repair;
-          }
-          return;
-        }
-      } else {
-        if (num_failed_chunk > code_n_ - code_k_) {
-          cout << "data loss" << endl;
-          if (CheckStripeDisksToRepair(*iter_stripe) == 1) {
-            //cout << "Current disk_idx = " << disk_idx << ", current stripe = " << *iter_stripe << endl;
-            for (iter_disk = disks_to_repair.begin(); iter_disk < disks_to_repair.end(); iter_disk++) {
-              if (find(stripe_disks_to_repair_[*iter_stripe].begin(), 
-                    stripe_disks_to_repair_[*iter_stripe].end(), *iter_disk) == 
-                  stripe_disks_to_repair_[*iter_stripe].end()) {
-                // this disk is not in stripe_disks_to_repair_[*iter_stripe]
-                stripe_disks_to_repair_[*iter_stripe].push_back(*iter_disk);
-              }
-            }
-          } else {
-            stripe_disks_to_repair_[*iter_stripe] = disks_to_repair;
           }
-          return;
+        } else {
+          stripe_disks_to_repair_[*iter_stripe] = disks_to_repair;
         }
+        return;
       }
+      lazy_counts_seen_ |= 1ULL << min(num_failed_chunk, 63);
       if (num_failed_chunk < lazy_repair_threshold_) {
+        if (lazy_burst_ != 0) stripe_lazy_burst_[*iter_stripe] = lazy_burst_;
         //cout << "num_failed_chunk = " << num_failed_chunk << ", lazy_repair_threshold = " << lazy_repair_threshold_ << endl;
         if (num_failed_chunk == 0) {
-          if (CheckStripeDisksToRepair(*iter_stripe) == 1) {
-            stripe_disks_to_repair_.erase(*iter_stripe);
+          if (it_pending != stripe_disks_to_repair_.end()) {
+            stripe_disks_to_repair_.erase(it_pending);
           }
         } else {
-          if (CheckStripeDisksToRepair(*iter_stripe) == 1) {
+          if (it_pending != stripe_disks_to_repair_.end()) {
             //cout << "Current disk_idx = " << disk_idx << ", current stripe = " << *iter_stripe << endl;
-            for (iter_disk = disks_to_repair.begin(); iter_disk < disks_to_repair.end(); iter_disk++) {
-              if (find(stripe_disks_to_repair_[*iter_stripe].begin(), 
-                    stripe_disks_to_repair_[*iter_stripe].end(), *iter_disk) == 
-                  stripe_disks_to_repair_[*iter_stripe].end()) {
+            vector<int>::iterator iter_repair;
+            for (iter_repair = disks_to_repair.begin(); iter_repair < disks_to_repair.end(); iter_repair++) {
+              if (find(it_pending->second.begin(), it_pending->second.end(), *iter_repair) == 
+                  it_pending->second.end()) {
                 // this disk is not in stripe_disks_to_repair_[*iter_stripe]
-                stripe_disks_to_repair_[*iter_stripe].push_back(*iter_disk);
+                it_pending->second.push_back(*iter_repair);
               }
             }
           } else {
@@ -376,20 +600,29 @@ void Simulation::SetDiskLazyRepair(int disk_idx, double curr_time){
 
         // need to check data loss here!!!!
         //cout << "num_failed_chunk = " << num_failed_chunk << ", lazy_repair_threshold = " << lazy_repair_threshold_ << endl;
-        for (iter_disk = disks_to_repair.begin(); iter_disk < disks_to_repair.end(); iter_disk++) {
+        vector<int>::iterator iter_repair;
+        for (iter_repair = disks_to_repair.begin(); iter_repair < disks_to_repair.end(); iter_repair++) {
           // avoid adding disk_idx into map_disk_stripes_in_repair
-          if (*iter_disk != disk_idx) {
-            map_disk_stripes_in_repair[*iter_disk].push_back(*iter_stripe);
+          if (*iter_repair != disk_idx) {
+            map_disk_stripes_in_repair[*iter_repair].push_back(*iter_stripe);
           }
         }
-        // it is okay to use erase even if *iter_stripe is not in the map
+        // it is okay to use erase even if *iter_stripe is not in the map;
+        // the disks added to the map above are crashed, so only the erase
+        // changes the failed chunks of the foreground reads
+        if (foreground_ != NULL) {
+          AddForegroundReads(curr_time);
+          AddDegradedStripe(*iter_stripe, -1);
+        }
         stripe_disks_to_repair_.erase(*iter_stripe);
+        if (foreground_ != NULL) AddDegradedStripe(*iter_stripe, 1);
       }
 
       // when this stripe will be repair
-      num_stripes_repaired_actual ++;
-      cross_rack_download += ComputeRepairTrafficForStripe(num_failed_chunk, 
-          num_alive_chunk_same_rack, alive_chunk_same_rack, fail_idx);
+      num_stripes_repaired_actual += placement_.GetStripeWeight(*iter_stripe);
+      cross_rack_download += placement_.GetStripeWeight(*iter_stripe) *
+        ComputeRepairTrafficForStripe(num_failed_chunk, num_alive_chunk_same_rack,
+            alive_chunk_same_rack, fail_idx);
     } // end of looping stripe
     num_stripes_repaired_ += num_stripes_repaired_actual;
     // Not consider cross rack upload for eager repair with multiple bad chunks since other disks may be still failed.
@@ -401,6 +634,10 @@ void Simulation::SetDiskLazyRepair(int disk_idx, double curr_time){
       Event e = {repair_time + curr_time, Disk::kEventDiskRepair, disk_idx, repair_bwth};
       events_queue_.push(e);
       disk_stripes_in_repair_[disk_idx] = map_disk_stripes_in_repair;
+      if (histograms_ != NULL) {
+        histograms_->repair_hours.Add(repair_time);
+        histograms_->repair_traffic_mb.Add(cross_rack_download * chunk_size_);
+      }
     }
   }
 }
@@ -415,18 +652,25 @@ void Simulation::SetDiskRepairFollowed(int disk_idx, double curr_time) {
     network_.UpdateAvailCrossRackRepairBwth(0.0);
     double cross_rack_upload = 0;
     map<int, vector<int> > map_disk_stripes = disk_stripes_in_repair_[disk_idx];
+    // chunks to upload to each disk, counting the stripes of a class
+    map<int, double> num_chunks_to_upload;
     for (map<int, vector<int> >::iterator it = map_disk_stripes.begin(); it != map_disk_stripes.end(); it++) {
-      cross_rack_upload += (it->second.size());
+      double num_chunks = 0;
+      for (vector<int>::iterator it_stripe = it->second.begin(); it_stripe < it->second.end(); it_stripe++) {
+        num_chunks += placement_.GetStripeWeight(*it_stripe);
+      }
+      num_chunks_to_upload[it->first] = num_chunks;
+      cross_rack_upload += num_chunks;
     }
     double repair_time = cross_rack_upload * chunk_size_ / repair_bwth / 3600.0; // hours
     for (map<int, vector<int> >::iterator it = map_disk_stripes.begin(); it != map_disk_stripes.end(); it ++) {
       if (disks_[it->first].GetCurrState() != Disk::kStateNormal) {
         Event e = {repair_time + curr_time, Disk::kEventDiskRepair, it->first, 
-          (double)it->second.size() / cross_rack_upload * repair_bwth};
+          num_chunks_to_upload[it->first] / cross_rack_upload * repair_bwth};
         events_queue_.push(e);
       } else {
         Event e = {repair_time + curr_time, Disk::kEventChunkRepair, it->first, 
-          (double)it->second.size() / cross_rack_upload * repair_bwth};
+          num_chunks_to_upload[it->first] / cross_rack_upload * repair_bwth};
         events_queue_.push(e);
       }
     }
@@ -524,6 +768,9 @@ bool Simulation::GetNextEvent(double curr_time, double *curr_event_time,
     if (use_network_ && (network_.GetAvailCrossRackRepairBwth() != 0) &&
         (network_.GetAvailIntraRackRepairBwth(rack_id) != 0)) {
       wait_repair_queue_.pop();
+      if (histograms_ != NULL) {
+        histograms_->wait_hours.Add(curr_time - e.event_time);
+      }
       if (lazy_repair_) {
         SetDiskLazyRepair(disk_id, curr_time);
       } else {
@@ -540,6 +787,9 @@ bool Simulation::GetNextEvent(double curr_time, double *curr_event_time,
   *curr_event_time = event.event_time;
   *curr_event_type = event.event_type;
   device_idx_set->push_back(event.element_id);
+  if (trace_iteration_) {
+    event_trace_.Record(event.event_time, event.event_type, event.element_id, event.repair_bwth);
+  }
   //printf("event_time = %lf, event_type = %s\n", *curr_event_time, (*curr_event_type).c_str());
   // If use network bandwidth to calculate repair time
   vector<double> repair_bwth_set;
@@ -555,6 +805,10 @@ bool Simulation::GetNextEvent(double curr_time, double *curr_event_time,
       strcmp(next_event.event_type.c_str(), event.event_type.c_str()) == 0) {
     events_queue_.pop();
     device_idx_set->push_back(next_event.element_id);
+    if (trace_iteration_) {
+      event_trace_.Record(next_event.event_time, next_event.event_type, 
+          next_event.element_id, next_event.repair_bwth);
+    }
     if (use_network_ && ((strcmp(next_event.event_type.c_str(), Disk::kEventDiskRepair.c_str()) == 0) ||
         (strcmp(next_event.event_type.c_str(), Disk::kEventChunkRepair.c_str()) == 0))) {
       repair_bwth_set.push_back(next_event.repair_bwth);
@@ -568,8 +822,15 @@ bool Simulation::GetNextEvent(double curr_time, double *curr_event_time,
       if (strcmp(disks_[*iter_disk].GetCurrState().c_str(), Disk::kStateCrashed.c_str()) != 0) {
         // first mark the disks as failed 
         disks_[*iter_disk].FailDisk(fail_time);
+        UpdateStripeFailures(*iter_disk, 1, fail_time);
       }
     }
+    // lazy repair: a stripe on several disks of the group is only evaluated by
+    // the first of them, the others would find the same failed chunks (eager
+    // repair gives the whole bandwidth to the first disk and queues the others)
+    if (lazy_repair_ && device_idx_set->size() > 1) {
+      lazy_burst_ = ++num_lazy_bursts_;
+    }
     for (iter_disk = device_idx_set->begin(); iter_disk < device_idx_set->end(); iter_disk++) {
       if (!lazy_repair_) {
         SetDiskRepair(*iter_disk, fail_time);
@@ -577,6 +838,7 @@ bool Simulation::GetNextEvent(double curr_time, double *curr_event_time,
           SetDiskLazyRepair(*iter_disk, fail_time);
       }
     }
+    lazy_burst_ = 0;
     return true;
   } else {
     // repair for disk failure
@@ -586,6 +848,7 @@ bool Simulation::GetNextEvent(double curr_time, double *curr_event_time,
       for (iter_disk = device_idx_set->begin(); iter_disk < device_idx_set->end(); iter_disk++) {
         if (strcmp(disks_[*iter_disk].GetCurrState().c_str(), Disk::kStateCrashed.c_str()) == 0) {
           disks_[*iter_disk].RepairDisk(repair_time);
+          UpdateStripeFailures(*iter_disk, -1, repair_time);
           if (!use_failure_trace_) {
             SetDiskFail(*iter_disk, repair_time);
           }
@@ -639,64 +902,428 @@ bool Simulation::GetNextEvent(double curr_time, double *curr_event_time,
   return false;
 }
 
-unsigned int Simulation::RunIteration(int *num_failed_stripes, int *num_lost_chunks) {
-  double curr_time = 0;
-  int num_failure_events = 0;
-  int num_repair_events = 0;
-
-  while (true) {
-    double event_time;
-    string event_type;
-    vector<int> disk_id_set;
-    if (!GetNextEvent(curr_time, &event_time, &event_type, &disk_id_set)) {
-      break;
-    }
-    curr_time = event_time;
-    if (curr_time > mission_time_) break;
-    
-    if (strcmp(event_type.c_str(), Disk::kEventDiskFail.c_str()) == 0) {
-      num_failure_events ++;
+// Process the next group of events. 
+int Simulation::Step(int *num_failed_stripes, int *num_lost_chunks) {
+  double event_time;
+  string event_type;
+  vector<int> disk_id_set;
+  if (!GetNextEvent(curr_time_, &event_time, &event_type, &disk_id_set)) {
+    if (foreground_ != NULL) AddForegroundReads(mission_time_);
+    return kStepEnd;
+  }
+  curr_time_ = event_time;
+  if (curr_time_ > mission_time_) return kStepEnd;
+  
+  if (strcmp(event_type.c_str(), Disk::kEventDiskFail.c_str()) == 0) {
+    num_failure_events_ ++;
+  } else {
+    if (strcmp(event_type.c_str(), Disk::kEventDiskRepair.c_str()) == 0) {
+      num_repair_events_ ++;
+    }
+  }
+  if (!state_.UpdateState(event_type, disk_id_set)) {
+    cout << "Update state failed!" << endl;
+  }
+  if (strcmp(event_type.c_str(), Disk::kEventDiskFail.c_str()) == 0) {
+    bool data_loss;
+    if (lazy_repair_) {
+      data_loss = placement_.CheckDataLoss(stripe_disks_to_repair_, num_failed_stripes,
+          num_lost_chunks);
     } else {
-      if (strcmp(event_type.c_str(), Disk::kEventDiskRepair.c_str()) == 0) {
-        num_repair_events ++;
-      }
+      data_loss = CheckBurstDataLoss(disk_id_set, num_failed_stripes, num_lost_chunks);
     }
-    if (!state_.UpdateState(event_type, disk_id_set)) {
-      cout << "Update state failed!" << endl;
+    if (data_loss) {
+      if (trace_iteration_) {
+        event_trace_.Record(curr_time_, EventTrace::kRecordDataLoss, *num_failed_stripes, 0);
+      }
+      return kStepDataLoss;
     }
-    if (strcmp(event_type.c_str(), Disk::kEventDiskFail.c_str()) == 0) {
-      if (lazy_repair_) {
-        bool data_loss = placement_.CheckDataLoss(stripe_disks_to_repair_, num_failed_stripes,
-            num_lost_chunks);
-        if (data_loss) {
-          cout << "num_failure events = " << num_failure_events << ", num_repair_events = " << num_repair_events << endl;
-          return 1;
-        }
-      } else {
-        vector<int> failed_disks = state_.GetFailedDisks();
-        bool data_loss = placement_.CheckDataLoss(failed_disks, num_failed_stripes, num_lost_chunks);
-        if (data_loss) {
-          cout << "num_failure events = " << num_failure_events << ", num_repair_events = " << num_repair_events << endl;
-          return 1;
-        }
+  }
+  return kStepContinue;
+}
+
+// The chunks on crashed disks and those left for a later lazy repair on
+// repaired disks are failed. A read of one of them is rebuilt as a repair
+// would rebuild it, from the other chunks of its stripe in other racks; a
+// stripe with several failed chunks needs code_k of them. sign is -1 before
+// the failed chunks of the stripe change and 1 after.
+void Simulation::AddDegradedStripe(int stripe_id, int sign) {
+  int num_failed_chunks = stripe_failed_chunks_[stripe_id];
+  if (!stripe_disks_to_repair_.empty()) {
+    map<int, vector<int> >::iterator it = stripe_disks_to_repair_.find(stripe_id);
+    if (it != stripe_disks_to_repair_.end()) {
+      for (vector<int>::iterator it_disk = it->second.begin(); it_disk < it->second.end(); it_disk++) {
+        if (!disk_failed_[*it_disk]) num_failed_chunks ++;
       }
     }
   }
-  cout << "num_failure events = " << num_failure_events << ", num_repair_events = " << num_repair_events << endl;
-  return 0;
+  if (num_failed_chunks == 0) return;
+  double chunks = (double)sign * placement_.GetStripeWeight(stripe_id) * num_failed_chunks;
+  degraded_chunks_ += chunks;
+  degraded_read_cost_ += chunks * (num_failed_chunks > 1 ? multi_read_cost_ : single_read_cost_);
+}
+
+// Reads from foreground_time_ to end_time, split at the bins of the mission
+// time.
+void Simulation::AddForegroundReads(double end_time) {
+  int num_bins = foreground_setting_.num_bins;
+  double bin_hours = mission_time_ / num_bins;
+  double time = foreground_time_;
+  while (time < end_time) {
+    int bin = min((int)(time / bin_hours), num_bins - 1);
+    double bin_end = bin == num_bins - 1 ? end_time : min(end_time, (bin + 1) * bin_hours);
+    if (bin_end <= time) bin_end = end_time;
+    double hours = bin_end - time;
+    double degraded_reads = degraded_chunks_ * chunk_read_rate_ * hours;
+    double extra_mb = degraded_read_cost_ * chunk_read_rate_ * hours * 
+      foreground_setting_.read_size;
+    foreground_->Add(bin, hours, degraded_chunks_ * hours, degraded_reads, extra_mb);
+    time = bin_end;
+  }
+  foreground_time_ = time;
+}
+
+// The failure times of a trace are the same in every iteration, only the 
+// repair times change. The filter is off where the trace of events, the
+// event counts in the log, the repair histograms or the foreground reads
+// would show the skipped failures.
+bool Simulation::UseDangerFilter() {
+  return danger_filter_ && use_failure_trace_ && !lazy_repair_ && !crn_ && use_network_ &&
+    network_setting_[0] > 0 && network_setting_[1] > 0 && !trace_iteration_ &&
+    !logger_.Enabled(Logger::kLogInfo) && histograms_ == NULL && foreground_ == NULL;
+}
+
+// With eager repair, a failed disk takes the whole cross-rack bandwidth or
+// waits for it behind the disks failed before, so each disk is repaired at
+// the latest when a queue of the failures in time order, each taking the
+// longest possible repair, serves it. Whenever that queue is empty, all
+// disks are repaired and the simulation is in its initial state, so the
+// busy periods of the queue are independent. Data loss needs failed chunks
+// in more than GetMaxFailedChunks() racks, as the chunks of a stripe are in
+// different racks; only the failures of the busy periods where that many
+// racks may have failed disks are kept.
+void Simulation::FindDangerousFailures(vector<FailedDisk> *failures) {
+  if (sorted_trace_.empty()) {
+    vector<FailedDisk>::iterator it;
+    for (it = trace_list_->begin(); it < trace_list_->end(); it++) {
+      if (it->fail_time <= mission_time_) sorted_trace_.push_back(*it);
+    }
+    stable_sort(sorted_trace_.begin(), sorted_trace_.end(), 
+        [](const FailedDisk &a, const FailedDisk &b) { return a.fail_time < b.fail_time; });
+  }
+  // a stripe needs at most max(code_k, 2) chunks from other racks (2 for a
+  // single chunk of DRC); the margin covers the rounding of the event times
+  double max_repair_time = (double)placement_.GetMaxChunksPerDisk() * max(code_k_, 2) *
+    chunk_size_ / network_setting_[0] / 3600.0 * (1 + 1e-6);
+  int num_failures = sorted_trace_.size();
+  // (time, failure + 1 when it fails or -failure - 1 when it is repaired)
+  vector<pair<double, int> > changes;
+  vector<int> period(num_failures);
+  int num_periods = 0;
+  double queue_end = -1;
+  int first = 0;
+  while (first < num_failures) {
+    double fail_time = sorted_trace_[first].fail_time;
+    // a failure when the queue ends may come before the last repair
+    if (fail_time > queue_end) num_periods ++;
+    int last = first;
+    while (last < num_failures && sorted_trace_[last].fail_time == fail_time) {
+      queue_end = max(queue_end, fail_time) + max_repair_time;
+      last++;
+    }
+    // the failures at the same time may be repaired in any order
+    for (int i = first; i < last; i++) {
+      period[i] = num_periods - 1;
+      changes.push_back(make_pair(fail_time, i + 1));
+      changes.push_back(make_pair(queue_end, -i - 1));
+    }
+    first = last;
+  }
+  // at equal times, failures come before repairs
+  sort(changes.begin(), changes.end(), 
+      [](const pair<double, int> &a, const pair<double, int> &b) {
+        if (a.first != b.first) return a.first < b.first;
+        return a.second > 0 && b.second < 0;
+      });
+  vector<bool> dangerous(num_periods, false);
+  vector<int> rack_failures(num_racks_, 0);
+  int num_failed_racks = 0;
+  int max_failed_chunks = GetMaxFailedChunks();
+  vector<pair<double, int> >::iterator it;
+  for (it = changes.begin(); it < changes.end(); it++) {
+    int i = it->second > 0 ? it->second - 1 : -it->second - 1;
+    int rack_id = disk_rack_[sorted_trace_[i].disk_id];
+    if (it->second > 0) {
+      if (rack_failures[rack_id]++ == 0) num_failed_racks ++;
+      if (num_failed_racks > max_failed_chunks) dangerous[period[i]] = true;
+    } else {
+      if (--rack_failures[rack_id] == 0) num_failed_racks --;
+    }
+  }
+  failures->clear();
+  for (int i = 0; i < num_failures; i++) {
+    if (dangerous[period[i]]) failures->push_back(sorted_trace_[i]);
+  }
 }
 
-void Simulation::Run(unsigned int *data_loss, unsigned long *tot_num_failed_stripes,
-    unsigned long *tot_num_lost_chunks) {
-  *data_loss = 0;
-  *tot_num_failed_stripes = 0;
-  *tot_num_lost_chunks = 0;
+unsigned int Simulation::RunIteration(int *num_failed_stripes, int *num_lost_chunks) {
+  if (UseDangerFilter()) {
+    // replace the failure events of InitFailureEvents(); CompareEventTime
+    // pops the kept ones in the same order as in a full run
+    vector<FailedDisk> failures;
+    FindDangerousFailures(&failures);
+    events_queue_ = priority_queue<Event, vector<Event>, CompareEventTime>();
+    for (vector<FailedDisk>::iterator it = failures.begin(); it < failures.end(); it++) {
+      Event e = {it->fail_time, Disk::kEventDiskFail, it->disk_id, 0};
+      events_queue_.push(e);
+    }
+  }
+  int status;
+  do {
+    status = Step(num_failed_stripes, num_lost_chunks);
+  } while (status == kStepContinue);
+  logger_.Log(Logger::kLogInfo, "num_failure events = %d, num_repair_events = %d", 
+      num_failure_events_, num_repair_events_);
+  if (histograms_ != NULL) {
+    if (status == kStepDataLoss) {
+      histograms_->data_loss_hours.Add(curr_time_);
+      CloseDegradedPeriods(curr_time_);
+    } else {
+      CloseDegradedPeriods(mission_time_);
+    }
+  }
+  return status == kStepDataLoss ? 1 : 0;
+}
 
-  for (int iter = 0; iter < num_iterations_; iter++) {
-    int num_failed_stripes, num_lost_chunks;
+void Simulation::Run(SimStats *stats) {
+  histograms_ = record_histograms_ ? &stats->histograms : NULL;
+  foreground_ = foreground_setting_.read_rate > 0 ? &stats->foreground : NULL;
+  // reads are spread evenly over the chunks of the cluster
+  chunk_read_rate_ = foreground_setting_.read_rate * 3600 * num_disks_ / 
+    ((double)num_stripes_ * code_n_);
+  if (foreground_ != NULL) {
+    vector<int> no_chunks;
+    single_read_cost_ = ComputeRepairTrafficForStripe(1, 0, no_chunks, 0);
+    multi_read_cost_ = ComputeRepairTrafficForStripe(2, 0, no_chunks, 0);
+  }
+  for (int iter = first_iteration_; iter < num_iterations_; iter++) {
+    int num_failed_stripes = 0, num_lost_chunks = 0;
+    // iterations are numbered globally across threads
+    int global_iter = thread_id_ * num_iterations_ + iter;
+    trace_iteration_ = !event_trace_fname_.empty() && 
+      event_trace_iters_.find(global_iter) != event_trace_iters_.end();
+    if (trace_iteration_ && !event_trace_.IsOpen()) {
+      event_trace_.Open(event_trace_fname_ + ".t" + to_string(thread_id_));
+    }
     Reset();
-    *data_loss += RunIteration(&num_failed_stripes, &num_lost_chunks);
-    *tot_num_failed_stripes += num_failed_stripes;
-    *tot_num_lost_chunks += num_lost_chunks;
+    stats->placement_seconds.Add(placement_seconds_);
+    if (trace_iteration_) {
+      event_trace_.Record(0.0, EventTrace::kRecordIterationBegin, global_iter, 0);
+    }
+    unsigned int data_loss = RunIteration(&num_failed_stripes, &num_lost_chunks);
+    stats->AddIteration(data_loss > 0, num_failed_stripes, num_lost_chunks);
+    if (progress_ != NULL) {
+      progress_->AddIteration(progress_task_, data_loss > 0);
+    }
+    if (!placement_dump_.empty() && (data_loss > 0 || placement_dump_all_)) {
+      DumpPlacement(global_iter);
+    }
+    if (trace_iteration_) {
+      event_trace_.Record(mission_time_, EventTrace::kRecordIterationEnd, global_iter, 0);
+    }
+    if (checkpoint_ != NULL && checkpoint_interval_ > 0 && 
+        (iter + 1) % checkpoint_interval_ == 0) {
+      ThreadState thread_state = {cluster_idx_, iter + 1, *stats, generator_};
+      checkpoint_->SaveThread(thread_id_, thread_state);
+    }
+  }
+  trace_iteration_ = false;
+  histograms_ = NULL;
+  foreground_ = NULL;
+  event_trace_.Close();
+  logger_.Flush();
+}
+
+void Simulation::SaveIterationState(IterationState *iteration_state) {
+  iteration_state->state = state_;
+  iteration_state->disks = disks_;
+  iteration_state->events_queue = events_queue_;
+  iteration_state->wait_repair_queue = wait_repair_queue_;
+  iteration_state->disk_stripes_in_repair = disk_stripes_in_repair_;
+  iteration_state->stripe_disks_to_repair = stripe_disks_to_repair_;
+  iteration_state->network = network_;
+  iteration_state->num_stripes_repaired = num_stripes_repaired_;
+  iteration_state->num_stripes_repaired_single_chunk = num_stripes_repaired_single_chunk_;
+  iteration_state->num_stripes_delayed = num_stripes_delayed_;
+  iteration_state->disk_fail_counts = disk_fail_counts_;
+  iteration_state->curr_time = curr_time_;
+  iteration_state->num_failure_events = num_failure_events_;
+  iteration_state->num_repair_events = num_repair_events_;
+}
+
+// The saved state is moved into the simulation and must not be used again.
+void Simulation::LoadIterationState(IterationState *iteration_state) {
+  state_ = iteration_state->state;
+  disks_.swap(iteration_state->disks);
+  events_queue_.swap(iteration_state->events_queue);
+  wait_repair_queue_.swap(iteration_state->wait_repair_queue);
+  disk_stripes_in_repair_.swap(iteration_state->disk_stripes_in_repair);
+  stripe_disks_to_repair_.swap(iteration_state->stripe_disks_to_repair);
+  network_ = iteration_state->network;
+  num_stripes_repaired_ = iteration_state->num_stripes_repaired;
+  num_stripes_repaired_single_chunk_ = iteration_state->num_stripes_repaired_single_chunk;
+  num_stripes_delayed_ = iteration_state->num_stripes_delayed;
+  disk_fail_counts_.swap(iteration_state->disk_fail_counts);
+  curr_time_ = iteration_state->curr_time;
+  num_failure_events_ = iteration_state->num_failure_events;
+  num_repair_events_ = iteration_state->num_repair_events;
+  RebuildStripeFailures();
+}
+
+void Simulation::SetRepairPolicy(const RepairPolicy &policy) {
+  lazy_repair_ = policy.lazy_repair;
+  lazy_repair_threshold_ = policy.lazy_repair_threshold;
+}
+
+// Whether the next step calls SetDiskLazyRepair(), the only place where lazy 
+// repair policies with different thresholds behave differently.
+bool Simulation::MayDiverge() {
+  if (!wait_repair_queue_.empty()) return true;
+  return !events_queue_.empty() && 
+    strcmp(events_queue_.top().event_type.c_str(), Disk::kEventDiskFail.c_str()) == 0;
+}
+
+// Whether a lazy threshold makes the same decisions as the threshold
+// used in the last step, given the numbers of failed chunks it compared.
+static bool SameLazyDecisions(unsigned long long counts_seen, int threshold_used,
+    int threshold) {
+  for (int count = 0; count < 64; count++) {
+    if ((counts_seen >> count & 1ULL) && 
+        (count < threshold_used) != (count < threshold)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Run the policies sharing the loaded state with the first of them. Before a
+// step that may diverge the state is saved; the policies that would have
+// decided differently are split off into a new branch from the saved state.
+void Simulation::RunBranch(vector<int> policies, vector<PolicyBranch> *pending,
+    vector<unsigned int> *data_loss, vector<int> *num_failed_stripes, 
+    vector<int> *num_lost_chunks) {
+  SetRepairPolicy(crn_policies_[policies[0]]);
+  int failed_stripes = 0, lost_chunks = 0;
+  int status;
+  do {
+    if (policies.size() > 1 && lazy_repair_ && MayDiverge()) {
+      PolicyBranch branch;
+      SaveIterationState(&branch.state);
+      lazy_counts_seen_ = 0;
+      status = Step(&failed_stripes, &lost_chunks);
+      vector<int> same;
+      for (vector<int>::iterator it = policies.begin(); it < policies.end(); it++) {
+        if (SameLazyDecisions(lazy_counts_seen_, lazy_repair_threshold_, 
+              crn_policies_[*it].lazy_repair_threshold)) {
+          same.push_back(*it);
+        } else {
+          branch.policies.push_back(*it);
+        }
+      }
+      if (!branch.policies.empty()) {
+        logger_.Log(Logger::kLogDebug, "fork at %lf: %d of %d policies", curr_time_,
+            (int)branch.policies.size(), (int)policies.size());
+        pending->push_back(branch);
+        policies = same;
+      }
+    } else {
+      status = Step(&failed_stripes, &lost_chunks);
+    }
+  } while (status == kStepContinue);
+  logger_.Log(Logger::kLogInfo, "num_failure events = %d, num_repair_events = %d", 
+      num_failure_events_, num_repair_events_);
+  for (vector<int>::iterator it = policies.begin(); it < policies.end(); it++) {
+    (*data_loss)[*it] = status == kStepDataLoss ? 1 : 0;
+    (*num_failed_stripes)[*it] = failed_stripes;
+    (*num_lost_chunks)[*it] = lost_chunks;
+  }
+}
+
+// Run every policy of crn_policies_ on the same sample in each iteration and
+// collect the per-policy statistics and the differences to the first policy.
+// The policies share one timeline until they make different repair 
+// decisions, and the timeline is forked there. Eager and lazy repair differ
+// from the first failure, lazy thresholds only once a stripe has as many
+// failed chunks as the smaller threshold.
+void Simulation::RunCrn(vector<SimStats> *stats, vector<PairedStats> *paired) {
+  int num_policies = crn_policies_.size();
+  stats->assign(num_policies, SimStats());
+  paired->assign(num_policies, PairedStats());
+  vector<unsigned int> data_loss(num_policies);
+  vector<int> num_failed_stripes(num_policies), num_lost_chunks(num_policies);
+  crn_ = true;
+  for (int iter = first_iteration_; iter < num_iterations_; iter++) {
+    int global_iter = thread_id_ * num_iterations_ + iter;
+    trace_iteration_ = !event_trace_fname_.empty() && 
+      event_trace_iters_.find(global_iter) != event_trace_iters_.end();
+    if (trace_iteration_ && !event_trace_.IsOpen()) {
+      event_trace_.Open(event_trace_fname_ + ".t" + to_string(thread_id_));
+    }
+    // the sample of this iteration: the placement and the seed of the 
+    // failure times
+    unsigned long long seed_high = generator_(), seed_low = generator_();
+    crn_seed_ = (seed_high << 32) | seed_low;
+    seed_seq seq = {(unsigned int)seed_high, (unsigned int)seed_low};
+    default_random_engine placement_generator(seq);
+    GeneratePlacement(&placement_generator);
+    ResetState();
+    InitFailureEvents();
+    if (trace_iteration_) {
+      event_trace_.Record(0.0, EventTrace::kRecordIterationBegin, global_iter, 0);
+    }
+    // eager and lazy repair take different paths from the first failure on
+    vector<PolicyBranch> pending(2);
+    for (int p = 0; p < num_policies; p++) {
+      pending[crn_policies_[p].lazy_repair ? 1 : 0].policies.push_back(p);
+    }
+    for (int b = 1; b >= 0; b--) {
+      if (pending[b].policies.empty()) {
+        pending.erase(pending.begin() + b);
+      }
+    }
+    for (size_t b = 1; b < pending.size(); b++) {
+      SaveIterationState(&pending[b].state);
+    }
+    vector<int> policies = pending[0].policies;
+    pending.erase(pending.begin());
+    while (true) {
+      RunBranch(policies, &pending, &data_loss, &num_failed_stripes, &num_lost_chunks);
+      if (trace_iteration_) {
+        event_trace_.Record(mission_time_, EventTrace::kRecordIterationEnd, global_iter, 0);
+      }
+      if (pending.empty()) break;
+      policies = pending.back().policies;
+      LoadIterationState(&pending.back().state);
+      pending.pop_back();
+    }
+    bool any_data_loss = false;
+    for (int p = 0; p < num_policies; p++) {
+      any_data_loss = any_data_loss || data_loss[p] > 0;
+      (*stats)[p].AddIteration(data_loss[p] > 0, num_failed_stripes[p], num_lost_chunks[p]);
+      (*stats)[p].placement_seconds.Add(placement_seconds_);
+      (*paired)[p].AddIteration(data_loss[p] > 0, num_lost_chunks[p], 
+          data_loss[0] > 0, num_lost_chunks[0]);
+    }
+    if (!placement_dump_.empty() && (any_data_loss || placement_dump_all_)) {
+      DumpPlacement(global_iter);
+    }
+    // the PDL of the first policy
+    if (progress_ != NULL) {
+      progress_->AddIteration(progress_task_, data_loss[0] > 0);
+    }
   }
+  crn_ = false;
+  trace_iteration_ = false;
+  event_trace_.Close();
+  logger_.Flush();
 }
@@ -1,3 +1,8 @@
+#ifndef SIMEDC_SIMULATION_HPP_
+#define SIMEDC_SIMULATION_HPP_
+
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <queue>
 #include <vector>
@@ -8,6 +13,13 @@
 #include "network.hpp"
 #include "state.hpp"
 #include "parser.hpp"
+#include "logger.hpp"
+#include "event_trace.hpp"
+#include "estimator.hpp"
+#include "checkpoint.hpp"
+#include "progress.hpp"
+#include "thread_pool.hpp"
+#include "numa.hpp"
 using namespace std;
 
 struct Event {
@@ -17,12 +29,69 @@ struct Event {
   double repair_bwth;
 };
 
+// Earliest first. Events of the same time pop by type, so that GetNextEvent()
+// gathers them, then by disk and bandwidth: the order does not depend on the
+// order of the pushes, and runs that skip events (danger_filter) process the
+// others in the same order as full runs.
 struct CompareEventTime {
   bool operator() (Event const& e1, Event const& e2) {
-    return e1.event_time > e2.event_time;
+    if (e1.event_time != e2.event_time) return e1.event_time > e2.event_time;
+    if (e1.event_type != e2.event_type) return e1.event_type > e2.event_type;
+    if (e1.element_id != e2.element_id) return e1.element_id > e2.element_id;
+    return e1.repair_bwth > e2.repair_bwth;
   }
 };
 
+// Repair traffic of a failed disk whose stripes have no other failed chunk.
+struct RepairCache {
+  bool valid;
+  double cross_rack_download;
+  int num_stripes;
+};
+
+class Simulation;
+
+// Stripes [first, last) of a disk repaired by SetDiskRepair(), scanned by one
+// task of the pool. The counts are weighted as the traffic.
+struct RepairScan {
+  Simulation *simulation;
+  const int *first, *last;
+  int disk_idx;
+  double cross_rack_download;
+  int num_stripes, num_stripes_single_chunk;
+  int loss_stripe; // the first stripe with data loss, which ends the scan, or -1
+};
+
+// Kernel results of the stripes [first, last) of a disk, from one task.
+struct MaskScan {
+  Simulation *simulation;
+  const int *first, *last;
+  int disk_idx;
+  StripeMasks *masks;
+};
+
+// Everything that changes while an iteration runs (the placement does not).
+// A copy is taken where the policies of a common-random-numbers run may
+// start to behave differently.
+struct IterationState {
+  State state;
+  vector<Disk> disks;
+  priority_queue<Event, vector<Event>, CompareEventTime> events_queue, wait_repair_queue;
+  map<int, map<int, vector<int> > > disk_stripes_in_repair;
+  map<int, vector<int> > stripe_disks_to_repair;
+  Network network;
+  int num_stripes_repaired, num_stripes_repaired_single_chunk, num_stripes_delayed;
+  vector<int> disk_fail_counts;
+  double curr_time;
+  int num_failure_events, num_repair_events;
+};
+
+// Policies of a common-random-numbers run that share one timeline.
+struct PolicyBranch {
+  vector<int> policies;
+  IterationState state;
+};
+
 class Simulation {
   private:
     int num_iterations_;
@@ -55,7 +124,132 @@ class Simulation {
     int num_stripes_repaired_, num_stripes_repaired_single_chunk_;
     int num_stripes_delayed_;
 
+    int thread_id_;
+    Logger logger_;
+    // binary dump of the events in the iterations listed in event_trace_iters_
+    EventTrace event_trace_;
+    string event_trace_fname_;
+    set<int> event_trace_iters_;
+    bool trace_iteration_;
+
+    // the thread state is saved every checkpoint_interval_ iterations
+    Checkpoint *checkpoint_;
+    int checkpoint_interval_;
+    // iterations counted in task progress_task_, if any
+    ProgressReporter *progress_;
+    int progress_task_;
+    int cluster_idx_;
+    int first_iteration_;
+
+    PlacementOptions placement_options_;
+    // prefix of the placement files of the iterations with data loss, or of
+    // all the iterations with placement_dump_all_
+    string placement_dump_;
+    bool placement_dump_all_;
+    double placement_seconds_; // of the last GeneratePlacement()
+
+    // histogram_fname: the repair metrics of Run() go to histograms_, the
+    // histograms of its stats (NULL when they are not recorded); the time
+    // each stripe (class) got its number of failed chunks
+    bool record_histograms_;
+    RepairHistograms *histograms_;
+    vector<double> stripe_level_since_;
+
+    // read_rate: the foreground reads of Run() go to foreground_, the
+    // foreground stats of its stats (NULL when there are none). The reads are
+    // added up to foreground_time_; since then, degraded_chunks_ chunks are
+    // failed and a read of them costs degraded_read_cost_ chunks of cross-rack
+    // traffic in total, both kept up to date by AddDegradedStripe().
+    ForegroundSetting foreground_setting_;
+    ForegroundStats *foreground_;
+    double chunk_read_rate_; // reads per hour of a chunk
+    // cross-rack chunks read to rebuild a chunk of a stripe with one failed
+    // chunk and with several
+    double single_read_cost_, multi_read_cost_;
+    double degraded_chunks_, degraded_read_cost_;
+    double foreground_time_;
+
+    // common-random-numbers mode: the policies run on the same placement and
+    // failure sample in every iteration, disk failure times are drawn from a
+    // counter-based stream keyed by (iteration seed, disk, failure number)
+    vector<RepairPolicy> crn_policies_;
+    bool crn_;
+    unsigned long long crn_seed_;
+    vector<int> disk_fail_counts_;
+    // numbers of failed chunks compared with the lazy repair threshold in the
+    // last step, one bit per number
+    unsigned long long lazy_counts_seen_;
+
+    double curr_time_;
+    int num_failure_events_, num_repair_events_;
+
+    // failed chunks of each stripe (class), and for each disk the number of
+    // its stripes with more than one failed chunk, kept up to date on every
+    // failure and repair; disk_repair_cache_ holds the traffic of SetDiskRepair()
+    // for the disks where that number is 0, and is kept for a placement
+    vector<unsigned char> stripe_failed_chunks_;
+    // inputs of kernel_: a byte per disk, 1 if crashed, also kept up to date
+    // on every failure and repair, and the rack of each disk
+    StripeKernel kernel_;
+    vector<unsigned char> disk_failed_;
+    vector<int> disk_rack_;
+    vector<int> disk_shared_failures_;
+    vector<RepairCache> disk_repair_cache_;
+    // stripes of the disks failed by one event group, see CheckBurstDataLoss()
+    vector<int> burst_stripes_;
+    // lazy repair: the stripes found below the threshold while repairing a
+    // group of disks failed at once, marked with the number of the group
+    // (lazy_burst_, 0 outside of a group); the other disks of the group skip them
+    vector<unsigned int> stripe_lazy_burst_;
+    unsigned int lazy_burst_, num_lazy_bursts_;
+    // trace mode with eager repair: an iteration only simulates the failures
+    // that may cause data loss, see FindDangerousFailures()
+    bool danger_filter_;
+    vector<FailedDisk> sorted_trace_; // failures within the mission, by time
+    // iteration_threads > 1: task pool of the stripe scans of a repair and of
+    // the placement, shared with the copies of the simulation
+    shared_ptr<ThreadPool> pool_;
+    static const int kStripesPerTask = 4096; // fewest stripes of a task
+    vector<RepairScan> repair_scans_;
+    vector<MaskScan> mask_scans_;
+    vector<StripeMasks> stripe_masks_; // see EvaluateStripes()
+
+    void InitKernel(const string &kernel_type);
+    int GetMaxFailedChunks();
+    bool UseDangerFilter();
+    void FindDangerousFailures(vector<FailedDisk> *failures);
+    void DumpPlacement(int global_iter);
+    void ResetStripeFailures();
+    void UpdateStripeFailures(int disk_idx, int delta, double curr_time);
+    void CloseDegradedPeriods(double end_time);
+    void AddDegradedStripe(int stripe_id, int sign);
+    void AddForegroundReads(double end_time);
+    void RebuildStripeFailures();
+    bool CheckBurstDataLoss(const vector<int> &disk_id_set, int *num_failed_stripes,
+        int *num_lost_chunks);
+    int GetNumScanTasks(int num_stripes);
+    void ScanRepairStripes(RepairScan *scan);
+    static void *RunRepairScan(void *args);
+    bool EvaluateStripes(IdRange stripes, int disk_idx);
+    static void *RunMaskScan(void *args);
+    void ResetState();
+    void InitFailureEvents();
+    void GeneratePlacement(default_random_engine *generator);
+    double DrawDiskFailTime(int disk_idx);
+    void SaveIterationState(IterationState *iteration_state);
+    void LoadIterationState(IterationState *iteration_state);
+    void SetRepairPolicy(const RepairPolicy &policy);
+    bool MayDiverge();
+    void RunBranch(vector<int> policies, vector<PolicyBranch> *pending, 
+        vector<unsigned int> *data_loss, vector<int> *num_failed_stripes, 
+        vector<int> *num_lost_chunks);
+
   public:
+    // results of Step()
+    static const int kStepContinue = 0;
+    static const int kStepEnd = 1;
+    static const int kStepDataLoss = 2;
+
     Simulation(Configure *configure);
     Simulation(int num_iterations, double mission_time, int num_racks, 
         int nodes_per_rack, int disks_per_node, long capacity_per_disk, 
@@ -77,8 +271,13 @@ class Simulation {
     int CheckStripeDisksToRepair(int stripe_id, int disk_id);
     bool GetNextEvent(double curr_time, double *curr_event_time,
         string *curr_event_type, vector<int> *device_idx_set);
+    int Step(int *num_failed_stripes, int *num_lost_chunks);
     unsigned int RunIteration(int *num_failed_stripes, int *num_lost_chunks);
-    void Run(unsigned int *data_loss, unsigned long *tot_num_failed_stripes, 
-        unsigned long *tot_num_lost_chunks);
+    void Run(SimStats *stats);
+    void RunCrn(vector<SimStats> *stats, vector<PairedStats> *paired);
+    // the random stream after the iterations run, to continue it later
+    const default_random_engine &GetGenerator() const { return generator_; }
 
 };
+
+#endif
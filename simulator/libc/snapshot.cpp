@@ -0,0 +1,93 @@
+#include "snapshot.hpp"
+
+static_assert(sizeof(long) == sizeof(int64_t), "disk offsets are stored as int64");
+
+const char Snapshot::kMagic[8] = {'S', 'I', 'M', 'E', 'D', 'C', 'P', 'L'};
+
+static int64_t AlignOffset(int64_t offset) {
+  return (offset + 7) / 8 * 8;
+}
+
+Snapshot::Snapshot():data_(NULL), size_(0) {}
+
+Snapshot::~Snapshot() {
+  if (data_ != NULL) {
+    munmap(data_, size_);
+  }
+}
+
+bool Snapshot::Open(const string &fname) {
+  fname_ = fname;
+  int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    cout << "Fail to open " << fname << "!" << endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapshotHeader)) {
+    cout << fname << " is not a placement file!" << endl;
+    close(fd);
+    return false;
+  }
+  size_ = st.st_size;
+  data_ = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data_ == MAP_FAILED) {
+    cout << "Fail to map " << fname << "!" << endl;
+    data_ = NULL;
+    return false;
+  }
+  const SnapshotHeader &header = GetHeader();
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    cout << fname << " is not a placement file!" << endl;
+    return false;
+  }
+  if (header.version != kVersion || header.header_size != sizeof(SnapshotHeader)) {
+    cout << fname << ": unsupported placement file version " << header.version << "!" << endl;
+    return false;
+  }
+  int64_t num_disks = (int64_t)header.num_racks * header.nodes_per_rack * header.disks_per_node;
+  if (header.file_size != (int64_t)size_ || header.code_n <= 0 || num_disks <= 0 ||
+      header.location_offset + header.num_classes * header.code_n * (int64_t)sizeof(int) >
+      header.weights_offset || header.disk_offsets_offset + (num_disks + 1) * 
+      (int64_t)sizeof(long) > header.stripes_offset || header.stripes_offset + 
+      header.num_entries * (int64_t)sizeof(int) > header.file_size) {
+    cout << fname << " is truncated or corrupted!" << endl;
+    return false;
+  }
+  return true;
+}
+
+bool Snapshot::Write(const string &fname, SnapshotHeader header, const int *location,
+    const int *weights, const long *disk_offsets, const int *stripes_per_disk) {
+  int64_t num_disks = (int64_t)header.num_racks * header.nodes_per_rack * header.disks_per_node;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.header_size = sizeof(SnapshotHeader);
+  header.location_offset = AlignOffset(sizeof(SnapshotHeader));
+  header.weights_offset = AlignOffset(header.location_offset +
+      header.num_classes * header.code_n * sizeof(int));
+  header.disk_offsets_offset = AlignOffset(header.weights_offset +
+      (weights != NULL ? header.num_classes * sizeof(int) : 0));
+  header.stripes_offset = header.disk_offsets_offset + (num_disks + 1) * sizeof(long);
+  header.file_size = header.stripes_offset + header.num_entries * sizeof(int);
+
+  ofstream outfile(fname, ofstream::out | ofstream::binary);
+  if (outfile.fail()) {
+    cout << "Fail to open " << fname << "!" << endl;
+    return false;
+  }
+  const char padding[8] = {0};
+  outfile.write((const char *)&header, sizeof(header));
+  outfile.write(padding, header.location_offset - sizeof(header));
+  outfile.write((const char *)location, header.num_classes * header.code_n * sizeof(int));
+  outfile.write(padding, header.weights_offset - outfile.tellp());
+  if (weights != NULL) {
+    outfile.write((const char *)weights, header.num_classes * sizeof(int));
+  }
+  outfile.write(padding, header.disk_offsets_offset - outfile.tellp());
+  outfile.write((const char *)disk_offsets, (num_disks + 1) * sizeof(long));
+  outfile.write((const char *)stripes_per_disk, header.num_entries * sizeof(int));
+  outfile.close();
+  return !outfile.fail();
+}
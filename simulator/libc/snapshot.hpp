@@ -0,0 +1,74 @@
+#ifndef SIMEDC_SNAPSHOT_HPP_
+#define SIMEDC_SNAPSHOT_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+// Header of a placement file. The header is followed by the arrays of the
+// placement, each at an offset aligned to 8 bytes, in host byte order:
+//   location          int32[num_classes * code_n]  disks of each stripe
+//   weights           int32[num_classes]           only if compress
+//   disk_offsets      int64[num_disks + 1]         CSR offsets
+//   stripes_per_disk  int32[num_entries]           CSR stripe ids
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  int32_t num_racks, nodes_per_rack, disks_per_node;
+  int32_t code_n, code_k, code_l;
+  char code_type[8];
+  char place_type[16];
+  int32_t compress;
+  uint32_t seed[2]; // of the random streams of the blocks
+  int32_t reserved;
+  int64_t num_stripes, num_classes, num_entries;
+  int64_t location_offset, weights_offset, disk_offsets_offset, stripes_offset;
+  int64_t file_size;
+};
+
+// Read-only memory mapping of a placement file, shared by the processes
+// (and threads) that load the same file.
+class Snapshot {
+  private:
+    string fname_;
+    void *data_;
+    size_t size_;
+
+    Snapshot(const Snapshot &);
+    Snapshot &operator=(const Snapshot &);
+
+  public:
+    static const char kMagic[8];
+    static const uint32_t kVersion = 1;
+
+    Snapshot();
+    ~Snapshot();
+    bool Open(const string &fname);
+    const SnapshotHeader &GetHeader() const { return *(const SnapshotHeader *)data_; }
+    const int *GetLocation() const { return GetArray<int>(GetHeader().location_offset); }
+    const int *GetWeights() const { return GetArray<int>(GetHeader().weights_offset); }
+    const long *GetDiskOffsets() const {
+      return GetArray<long>(GetHeader().disk_offsets_offset);
+    }
+    const int *GetStripesPerDisk() const { return GetArray<int>(GetHeader().stripes_offset); }
+
+    template <typename T>
+    const T *GetArray(int64_t offset) const {
+      return (const T *)((const char *)data_ + offset);
+    }
+
+    // Fill the offsets and the size of header and write the file. weights is
+    // NULL without compression.
+    static bool Write(const string &fname, SnapshotHeader header, const int *location,
+        const int *weights, const long *disk_offsets, const int *stripes_per_disk);
+};
+
+#endif
@@ -3,10 +3,12 @@
 const string State::kCurrStateOK = "system is operational";
 const string State::kCurrStateDegraded = "system has at least one failure";
 
-State::State(){}
+State::State():num_disks_(0), num_failed_disks_(0) {}
 
 State::State(int num_disks)
-  :num_disks_(num_disks), num_failed_disks_(0), sys_state_(kCurrStateOK){}
+  :num_disks_(num_disks), bm_avail_disks_(num_disks, false), 
+   bm_failed_disks_(num_disks, false), num_failed_disks_(0), 
+   sys_state_(kCurrStateOK){}
 
 void State::UpdateSysState() {
   if (num_failed_disks_ == 0)
@@ -42,25 +44,31 @@ bool State::UpdateState(string event_type, vector<int> disk_id_set) {
 void State::FailDisk(int disk_id) {
   if (disk_id >= num_disks_ || disk_id < 0) {
     cout << "State - FailDisk(): Wrong disk_id!" << endl;
+    return;
   }
-  bm_failed_disks_.set(disk_id);
-  bm_avail_disks_.set(disk_id, 0);
-  num_failed_disks_ = bm_failed_disks_.count();
+  if (!bm_failed_disks_[disk_id]) {
+    bm_failed_disks_[disk_id] = true;
+    num_failed_disks_ ++;
+  }
+  bm_avail_disks_[disk_id] = false;
 }
 
 void State::RepairDisk(int disk_id) {
   if (disk_id >= num_disks_ || disk_id < 0) {
-    cout << "State - FailDisk(): Wrong disk_id!" << endl;
+    cout << "State - RepairDisk(): Wrong disk_id!" << endl;
+    return;
+  }
+  if (bm_failed_disks_[disk_id]) {
+    bm_failed_disks_[disk_id] = false;
+    num_failed_disks_ --;
   }
-  bm_failed_disks_.set(disk_id, 0);
-  bm_avail_disks_.set(disk_id);
-  num_failed_disks_ = bm_failed_disks_.count();
+  bm_avail_disks_[disk_id] = true;
 }
 
 vector<int> State::GetFailedDisks() {
   vector<int> failed_disks;
   for (int i = 0; i < num_disks_; i++) {
-    if (bm_failed_disks_.test(i) == 1) {
+    if (bm_failed_disks_[i]) {
       failed_disks.push_back(i);
     }
   }
@@ -70,8 +78,8 @@ vector<int> State::GetFailedDisks() {
 void State::Copy(State state) {
   num_disks_ = state.GetNumDisks();
   num_failed_disks_ = state.GetNumFailedDisks();
-  bm_failed_disks_ = bitset<MAX>(state.GetBmFailedDisks());
-  bm_avail_disks_ = bitset<MAX>(state.GetBmAvailDisks());
+  bm_failed_disks_ = state.GetBmFailedDisks();
+  bm_avail_disks_ = state.GetBmAvailDisks();
   sys_state_ = state.GetSysState();
 }
 
@@ -84,12 +92,12 @@ int State::GetNumFailedDisks() {
   return num_failed_disks_;
 }
 
-unsigned long State::GetBmFailedDisks() {
-  return bm_failed_disks_.to_ulong();
+const vector<bool> &State::GetBmFailedDisks() {
+  return bm_failed_disks_;
 }
 
-unsigned long State::GetBmAvailDisks() {
-  return bm_avail_disks_.to_ulong();
+const vector<bool> &State::GetBmAvailDisks() {
+  return bm_avail_disks_;
 }
 
 string State::GetSysState() {
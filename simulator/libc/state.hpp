@@ -1,19 +1,20 @@
+#ifndef SIMEDC_STATE_HPP_
+#define SIMEDC_STATE_HPP_
+
 #include <cstring>
 #include <iostream>
 #include <string>
-#include <bitset>
 #include <vector>
 #include "disk.hpp"
 using namespace std;
 
-#define MAX 400000
-
 class State{
   private:
     static const string kCurrStateOK;
     static const string kCurrStateDegraded;
     int num_disks_;
-    bitset<MAX> bm_avail_disks_, bm_failed_disks_;
+    // one bit per disk, sized to the cluster
+    vector<bool> bm_avail_disks_, bm_failed_disks_;
     int num_failed_disks_;
     string sys_state_;
 
@@ -28,7 +29,9 @@ class State{
     void Copy(State state);
     int GetNumDisks();
     int GetNumFailedDisks();
-    unsigned long GetBmFailedDisks();
-    unsigned long GetBmAvailDisks();
+    const vector<bool> &GetBmFailedDisks();
+    const vector<bool> &GetBmAvailDisks();
     string GetSysState();
 };
+
+#endif
@@ -0,0 +1,138 @@
+#include "strategy.hpp"
+
+const vector<string> PlacementStrategy::kTypes = {"flat", "copyset", "rackgroup", "node"};
+
+PlacementStrategy::PlacementStrategy(int num_racks, int nodes_per_rack,
+    int disks_per_node, int code_n)
+  :num_racks_(num_racks), nodes_per_rack_(nodes_per_rack),
+   disks_per_node_(disks_per_node), disks_per_rack_(nodes_per_rack * disks_per_node),
+   code_n_(code_n) {
+}
+
+void PlacementStrategy::InitScratch(vector<int> *scratch) const {
+  scratch->resize(num_racks_);
+  for (int rack_id = 0; rack_id < num_racks_; rack_id++) {
+    (*scratch)[rack_id] = rack_id;
+  }
+}
+
+void PlacementStrategy::PickRacks(default_random_engine *generator,
+    vector<int> *racks, int first, int last) const {
+  for (int i = first; i < first + code_n_; i++) {
+    uniform_int_distribution<int> rack_dist(i, last - 1);
+    swap((*racks)[i], (*racks)[rack_dist(*generator)]);
+  }
+}
+
+bool PlacementStrategy::IsValidType(const string &place_type) {
+  return find(kTypes.begin(), kTypes.end(), place_type) != kTypes.end();
+}
+
+PlacementStrategy *PlacementStrategy::Create(const string &place_type, int num_racks,
+    int nodes_per_rack, int disks_per_node, int code_n, int scatter_width) {
+  if (place_type == "flat") {
+    return new FlatStrategy(num_racks, nodes_per_rack, disks_per_node, code_n);
+  } else if (place_type == "copyset") {
+    return new CopysetStrategy(num_racks, nodes_per_rack, disks_per_node, code_n,
+        scatter_width);
+  } else if (place_type == "rackgroup") {
+    return new RackGroupStrategy(num_racks, nodes_per_rack, disks_per_node, code_n);
+  } else if (place_type == "node") {
+    return new NodeAwareStrategy(num_racks, nodes_per_rack, disks_per_node, code_n);
+  }
+  return NULL;
+}
+
+FlatStrategy::FlatStrategy(int num_racks, int nodes_per_rack, int disks_per_node,
+    int code_n)
+  :PlacementStrategy(num_racks, nodes_per_rack, disks_per_node, code_n) {
+}
+
+void FlatStrategy::PlaceStripe(default_random_engine *generator, vector<int> *scratch,
+    int *disk_list) const {
+  uniform_int_distribution<int> disk_dist(0, disks_per_rack_ - 1);
+  for (int i = 0; i < code_n_; i++) {
+    uniform_int_distribution<int> rack_dist(i, num_racks_ - 1);
+    swap((*scratch)[i], (*scratch)[rack_dist(*generator)]);
+    disk_list[i] = (*scratch)[i] * disks_per_rack_ + disk_dist(*generator);
+  }
+}
+
+CopysetStrategy::CopysetStrategy(int num_racks, int nodes_per_rack, int disks_per_node,
+    int code_n, int scatter_width)
+  :PlacementStrategy(num_racks, nodes_per_rack, disks_per_node, code_n) {
+  if (scatter_width < code_n - 1) scatter_width = code_n - 1;
+  num_permutations_ = (scatter_width + code_n - 2) / (code_n - 1);
+}
+
+void CopysetStrategy::Init(default_random_engine *generator) {
+  int num_groups = (num_racks_ + code_n_ - 1) / code_n_;
+  vector<int> racks(num_racks_);
+  vector<vector<int> > slots(num_racks_, vector<int>(disks_per_rack_));
+  copysets_.clear();
+  copysets_.reserve((long)num_permutations_ * num_groups * disks_per_rack_ * code_n_);
+  for (int p = 0; p < num_permutations_; p++) {
+    for (int rack_id = 0; rack_id < num_racks_; rack_id++) {
+      racks[rack_id] = rack_id;
+      for (int slot = 0; slot < disks_per_rack_; slot++) {
+        slots[rack_id][slot] = slot;
+      }
+      shuffle(slots[rack_id].begin(), slots[rack_id].end(), *generator);
+    }
+    shuffle(racks.begin(), racks.end(), *generator);
+    for (int g = 0; g < num_groups; g++) {
+      for (int slot = 0; slot < disks_per_rack_; slot++) {
+        for (int i = 0; i < code_n_; i++) {
+          int rack_id = racks[(g * code_n_ + i) % num_racks_];
+          copysets_.push_back(rack_id * disks_per_rack_ + slots[rack_id][slot]);
+        }
+      }
+    }
+  }
+}
+
+void CopysetStrategy::PlaceStripe(default_random_engine *generator, vector<int> *,
+    int *disk_list) const {
+  uniform_int_distribution<int> copyset_dist(0, GetNumCopysets() - 1);
+  copy_n(copysets_.begin() + (long)copyset_dist(*generator) * code_n_, code_n_, disk_list);
+}
+
+RackGroupStrategy::RackGroupStrategy(int num_racks, int nodes_per_rack,
+    int disks_per_node, int code_n)
+  :PlacementStrategy(num_racks, nodes_per_rack, disks_per_node, code_n),
+   num_groups_(num_racks / code_n), rack_group_(num_racks) {
+  for (int g = 0; g < num_groups_; g++) {
+    for (int rack_id = GetFirstRack(g); rack_id < GetFirstRack(g + 1); rack_id++) {
+      rack_group_[rack_id] = g;
+    }
+  }
+}
+
+void RackGroupStrategy::PlaceStripe(default_random_engine *generator,
+    vector<int> *scratch, int *disk_list) const {
+  uniform_int_distribution<int> rack_dist(0, num_racks_ - 1);
+  uniform_int_distribution<int> disk_dist(0, disks_per_rack_ - 1);
+  int g = rack_group_[rack_dist(*generator)];
+  int first = GetFirstRack(g);
+  // racks of a group stay in their range of scratch
+  PickRacks(generator, scratch, first, GetFirstRack(g + 1));
+  for (int i = 0; i < code_n_; i++) {
+    disk_list[i] = (*scratch)[first + i] * disks_per_rack_ + disk_dist(*generator);
+  }
+}
+
+NodeAwareStrategy::NodeAwareStrategy(int num_racks, int nodes_per_rack,
+    int disks_per_node, int code_n)
+  :PlacementStrategy(num_racks, nodes_per_rack, disks_per_node, code_n) {
+}
+
+void NodeAwareStrategy::PlaceStripe(default_random_engine *generator,
+    vector<int> *scratch, int *disk_list) const {
+  uniform_int_distribution<int> node_dist(0, nodes_per_rack_ - 1);
+  uniform_int_distribution<int> disk_dist(0, disks_per_node_ - 1);
+  int first_disk = node_dist(*generator) * disks_per_node_;
+  PickRacks(generator, scratch, 0, num_racks_);
+  for (int i = 0; i < code_n_; i++) {
+    disk_list[i] = (*scratch)[i] * disks_per_rack_ + first_disk + disk_dist(*generator);
+  }
+}
@@ -0,0 +1,96 @@
+#ifndef SIMEDC_STRATEGY_HPP_
+#define SIMEDC_STRATEGY_HPP_
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Chooses the disks of each stripe of a placement, one chunk per rack. Disk d
+// is in rack d / disks_per_rack and node d / disks_per_node, as in Simulation.
+//
+// A strategy is shared by the threads generating a placement: Init() runs
+// once before them, PlaceStripe() only reads the strategy and writes the
+// scratch vector of the calling thread, which InitScratch() resets at the
+// start of every block of stripes.
+class PlacementStrategy {
+  protected:
+    int num_racks_, nodes_per_rack_, disks_per_node_, disks_per_rack_;
+    int code_n_;
+
+    // partial Fisher-Yates over racks[first, last): the first code_n_ racks
+    // end up at racks[first, first + code_n_)
+    void PickRacks(default_random_engine *generator, vector<int> *racks,
+        int first, int last) const;
+
+  public:
+    PlacementStrategy(int num_racks, int nodes_per_rack, int disks_per_node, int code_n);
+    virtual ~PlacementStrategy() {}
+    virtual void Init(default_random_engine *) {}
+    virtual void InitScratch(vector<int> *scratch) const;
+    virtual void PlaceStripe(default_random_engine *generator, vector<int> *scratch,
+        int *disk_list) const = 0;
+
+    static const vector<string> kTypes; // flat first
+    static bool IsValidType(const string &place_type);
+    // NULL for an unknown type; scatter_width is only used by copyset
+    static PlacementStrategy *Create(const string &place_type, int num_racks,
+        int nodes_per_rack, int disks_per_node, int code_n, int scatter_width);
+};
+
+// Distinct random racks and a random disk in each of them.
+class FlatStrategy : public PlacementStrategy {
+  public:
+    FlatStrategy(int num_racks, int nodes_per_rack, int disks_per_node, int code_n);
+    void PlaceStripe(default_random_engine *generator, vector<int> *scratch,
+        int *disk_list) const;
+};
+
+// Copyset replication: every stripe is placed on one of a fixed list of
+// copysets. Each permutation of the disks splits the shuffled racks into
+// groups of code_n racks and builds one copyset per disk slot of the group;
+// the last group is completed with the first racks of the permutation, so
+// with num_racks not a multiple of code_n those racks get a larger share of
+// stripes. ceil(scatter_width / (code_n - 1)) permutations are used.
+class CopysetStrategy : public PlacementStrategy {
+  private:
+    int num_permutations_;
+    vector<int> copysets_; // code_n_ disks per copyset
+
+  public:
+    CopysetStrategy(int num_racks, int nodes_per_rack, int disks_per_node, int code_n,
+        int scatter_width);
+    void Init(default_random_engine *generator);
+    void PlaceStripe(default_random_engine *generator, vector<int> *scratch,
+        int *disk_list) const;
+    int GetNumCopysets() const { return copysets_.size() / code_n_; }
+};
+
+// The racks are split into num_racks / code_n groups of consecutive racks;
+// a stripe picks a group with probability proportional to its number of
+// racks and flat placement inside the group.
+class RackGroupStrategy : public PlacementStrategy {
+  private:
+    int num_groups_;
+    vector<int> rack_group_;
+
+    int GetFirstRack(int g) const { return (long)g * num_racks_ / num_groups_; }
+
+  public:
+    RackGroupStrategy(int num_racks, int nodes_per_rack, int disks_per_node, int code_n);
+    void PlaceStripe(default_random_engine *generator, vector<int> *scratch,
+        int *disk_list) const;
+};
+
+// Distinct random racks, the node with the same index in each of them and a
+// random disk of that node: a stripe only spans the nodes with one index, so
+// failures of nodes with different indices never share a stripe.
+class NodeAwareStrategy : public PlacementStrategy {
+  public:
+    NodeAwareStrategy(int num_racks, int nodes_per_rack, int disks_per_node, int code_n);
+    void PlaceStripe(default_random_engine *generator, vector<int> *scratch,
+        int *disk_list) const;
+};
+
+#endif
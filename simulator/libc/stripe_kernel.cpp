@@ -0,0 +1,119 @@
+#include "stripe_kernel.hpp"
+#include <immintrin.h>
+
+const string StripeKernel::kTypeAuto = "auto";
+const string StripeKernel::kTypeAvx512 = "avx512";
+const string StripeKernel::kTypeAvx2 = "avx2";
+const string StripeKernel::kTypeScalar = "scalar";
+const vector<string> StripeKernel::kTypes = {kTypeAuto, kTypeAvx512, kTypeAvx2, kTypeScalar};
+
+static StripeMasks EvaluateScalar(const int *disks, int num_chunks,
+    const unsigned char *disk_failed, const int *disk_rack, int disk_idx, int rack_id) {
+  StripeMasks masks = {0, 0, 0};
+  for (int i = 0; i < num_chunks; i++) {
+    unsigned long long bit = 1ULL << i;
+    if (disk_failed[disks[i]]) {
+      masks.failed |= bit;
+    } else if (disk_rack != NULL && disk_rack[disks[i]] == rack_id) {
+      masks.same_rack_alive |= bit;
+    }
+    if (disks[i] == disk_idx) masks.repaired |= bit;
+  }
+  return masks;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static StripeMasks EvaluateAvx2(const int *disks, int num_chunks,
+    const unsigned char *disk_failed, const int *disk_rack, int disk_idx, int rack_id) {
+  StripeMasks masks = {0, 0, 0};
+  const __m256i lane_ids = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i byte_mask = _mm256_set1_epi32(0xff);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i target_disk = _mm256_set1_epi32(disk_idx);
+  const __m256i target_rack = _mm256_set1_epi32(rack_id);
+  for (int first = 0; first < num_chunks; first += 8) {
+    int num_lanes = min(8, num_chunks - first);
+    unsigned long long lane_bits = (1ULL << num_lanes) - 1;
+    // the lanes past the stripe load disk 0, which is always readable
+    __m256i lanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(num_lanes), lane_ids);
+    __m256i ids = _mm256_maskload_epi32(disks + first, lanes);
+    __m256i states = _mm256_and_si256(
+        _mm256_i32gather_epi32((const int *)disk_failed, ids, 1), byte_mask);
+    unsigned long long alive = _mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpeq_epi32(states, zero)));
+    unsigned long long repaired = _mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpeq_epi32(ids, target_disk)));
+    masks.failed |= (~alive & lane_bits) << first;
+    masks.repaired |= (repaired & lane_bits) << first;
+    if (disk_rack != NULL) {
+      __m256i racks = _mm256_i32gather_epi32(disk_rack, ids, 4);
+      unsigned long long same_rack = _mm256_movemask_ps(
+          _mm256_castsi256_ps(_mm256_cmpeq_epi32(racks, target_rack)));
+      masks.same_rack_alive |= (same_rack & alive & lane_bits) << first;
+    }
+  }
+  return masks;
+}
+
+__attribute__((target("avx512f")))
+static StripeMasks EvaluateAvx512(const int *disks, int num_chunks,
+    const unsigned char *disk_failed, const int *disk_rack, int disk_idx, int rack_id) {
+  StripeMasks masks = {0, 0, 0};
+  const __m512i byte_mask = _mm512_set1_epi32(0xff);
+  const __m512i target_disk = _mm512_set1_epi32(disk_idx);
+  const __m512i target_rack = _mm512_set1_epi32(rack_id);
+  for (int first = 0; first < num_chunks; first += 16) {
+    int num_lanes = min(16, num_chunks - first);
+    __mmask16 lanes = (__mmask16)((1U << num_lanes) - 1);
+    // the lanes past the stripe load disk 0, which is always readable
+    __m512i ids = _mm512_maskz_loadu_epi32(lanes, disks + first);
+    __m512i states = _mm512_and_si512(_mm512_i32gather_epi32(ids, disk_failed, 1), byte_mask);
+    __mmask16 failed = _mm512_mask_test_epi32_mask(lanes, states, states);
+    __mmask16 repaired = _mm512_mask_cmpeq_epi32_mask(lanes, ids, target_disk);
+    masks.failed |= (unsigned long long)failed << first;
+    masks.repaired |= (unsigned long long)repaired << first;
+    if (disk_rack != NULL) {
+      __m512i racks = _mm512_i32gather_epi32(ids, disk_rack, 4);
+      __mmask16 same_rack = _mm512_mask_cmpeq_epi32_mask(lanes & ~failed, racks, target_rack);
+      masks.same_rack_alive |= (unsigned long long)same_rack << first;
+    }
+  }
+  return masks;
+}
+#endif
+
+StripeKernel::StripeKernel():evaluate_(EvaluateScalar), type_(kTypeScalar) {
+  Select(kTypeAuto);
+}
+
+bool StripeKernel::IsValidType(const string &type) {
+  return find(kTypes.begin(), kTypes.end(), type) != kTypes.end();
+}
+
+bool StripeKernel::IsSupported(const string &type) {
+  if (type == kTypeAuto || type == kTypeScalar) return true;
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (type == kTypeAvx512) return __builtin_cpu_supports("avx512f");
+  if (type == kTypeAvx2) return __builtin_cpu_supports("avx2");
+#endif
+  return false;
+}
+
+bool StripeKernel::Select(const string &type) {
+  if (!IsValidType(type) || !IsSupported(type)) return false;
+  string selected = type;
+  if (type == kTypeAuto) {
+    selected = kTypeScalar;
+    if (IsSupported(kTypeAvx2)) selected = kTypeAvx2;
+    if (IsSupported(kTypeAvx512)) selected = kTypeAvx512;
+  }
+  type_ = selected;
+  evaluate_ = EvaluateScalar;
+#if defined(__x86_64__) || defined(__i386__)
+  if (selected == kTypeAvx512) evaluate_ = EvaluateAvx512;
+  if (selected == kTypeAvx2) evaluate_ = EvaluateAvx2;
+#endif
+  return true;
+}
@@ -0,0 +1,66 @@
+#ifndef SIMEDC_STRIPE_KERNEL_HPP_
+#define SIMEDC_STRIPE_KERNEL_HPP_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Chunks of a stripe, bit i for the chunk on the i-th disk of the stripe.
+struct StripeMasks {
+  unsigned long long failed;
+  // alive chunks in the rack of the repaired disk
+  unsigned long long same_rack_alive;
+  // chunks on the repaired disk
+  unsigned long long repaired;
+};
+
+// Evaluates the chunks of a stripe from a byte per disk, nonzero if the disk
+// has failed, and the rack of each disk. The AVX-512 and AVX2 versions gather
+// the states and racks of 16 or 8 disks at once and compare them in a few
+// instructions; the scalar version loops over the chunks. The version is
+// picked when the kernel is created, from the CPU or the stripe_kernel key.
+//
+// The states are gathered 4 bytes at a time, so disk_failed must have
+// kPadding readable bytes after the last disk. disk_rack may be NULL when
+// same_rack_alive is not needed.
+class StripeKernel {
+  public:
+    typedef StripeMasks (*EvaluateFunc)(const int *disks, int num_chunks,
+        const unsigned char *disk_failed, const int *disk_rack, int disk_idx, int rack_id);
+
+    static const int kMaxChunks = 64;
+    static const int kPadding = 3;
+    static const string kTypeAuto;
+    static const string kTypeAvx512;
+    static const string kTypeAvx2;
+    static const string kTypeScalar;
+    static const vector<string> kTypes; // auto first
+
+    StripeKernel();
+    // false if the type is unknown or not supported by the CPU, the kernel
+    // is unchanged then
+    bool Select(const string &type);
+    const string &GetType() const { return type_; }
+    StripeMasks Evaluate(const int *disks, int num_chunks, const unsigned char *disk_failed,
+        const int *disk_rack, int disk_idx, int rack_id) const {
+      return evaluate_(disks, num_chunks, disk_failed, disk_rack, disk_idx, rack_id);
+    }
+
+    static bool IsValidType(const string &type);
+    static bool IsSupported(const string &type);
+
+  private:
+    EvaluateFunc evaluate_;
+    string type_;
+};
+
+// Position of each set bit of mask, in increasing order.
+inline void GetChunkIndices(unsigned long long mask, vector<int> *indices) {
+  indices->clear();
+  for (; mask != 0; mask &= mask - 1) {
+    indices->push_back(__builtin_ctzll(mask));
+  }
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include "synthetic.hpp"
+
+struct CompareFailTime {
+  bool operator() (FailedDisk const& d1, FailedDisk const& d2) {
+    return d1.fail_time < d2.fail_time;
+  }
+};
+
+// E[min(X, cap)] for X ~ Poisson(mean): the sum of P(X > j) for j < cap.
+static double GetCappedPoissonMean(double mean, int cap) {
+  double pmf = exp(-mean), cdf = 0.0, sum = 0.0;
+  for (int j = 0; j < cap; j++) {
+    cdf += pmf;
+    sum += max(0.0, 1.0 - cdf);
+    pmf *= mean / (j + 1);
+  }
+  return sum;
+}
+
+SyntheticGenerator::SyntheticGenerator(const SyntheticSetting &setting, int seed,
+    double period)
+  :setting_(setting), seed_(seed), period_(period) {
+}
+
+void SyntheticGenerator::GenerateTrace(const Meta &meta, int cluster_idx,
+    vector<FailedDisk> *trace_list) {
+  seed_seq seq = {seed_, cluster_idx};
+  default_random_engine generator(seq);
+  int num_disks = meta.total_disks;
+  int group_size = meta.disks_per_node;
+  if (setting_.burst_scope == "rack") {
+    group_size *= meta.nodes_per_rack;
+  }
+  // disk failures per event, so that the failure rate of a disk is afr
+  double failures_per_event = 1.0 + setting_.burst_prob *
+    GetCappedPoissonMean(setting_.burst_size, group_size - 1);
+  double mean_events = setting_.afr / 8760.0 * num_disks * period_ / failures_per_event;
+  poisson_distribution<long> num_events_dist(mean_events);
+  uniform_real_distribution<double> time_dist(0.0, period_);
+  uniform_real_distribution<double> window_dist(0.0, setting_.burst_window);
+  uniform_int_distribution<int> disk_dist(0, num_disks - 1);
+  bernoulli_distribution burst_dist(setting_.burst_prob);
+  poisson_distribution<int> burst_size_dist(max(setting_.burst_size, 1e-9));
+
+  long num_events = num_events_dist(generator);
+  trace_list->clear();
+  trace_list->reserve(num_events * failures_per_event);
+  vector<int> group;
+  for (long i = 0; i < num_events; i++) {
+    double fail_time = time_dist(generator);
+    int disk_id = disk_dist(generator);
+    FailedDisk failed_disk = {disk_id, fail_time};
+    trace_list->push_back(failed_disk);
+    if (setting_.burst_prob <= 0.0 || !burst_dist(generator)) {
+      continue;
+    }
+    // other disks of the node or rack, without repetition
+    int first_disk = disk_id / group_size * group_size;
+    int num_others = min(burst_size_dist(generator), group_size - 1);
+    group.clear();
+    for (int d = first_disk; d < first_disk + group_size; d++) {
+      if (d != disk_id) group.push_back(d);
+    }
+    for (int j = 0; j < num_others; j++) {
+      uniform_int_distribution<int> pick_dist(j, group.size() - 1);
+      swap(group[j], group[pick_dist(generator)]);
+      FailedDisk other = {group[j], fail_time + window_dist(generator)};
+      trace_list->push_back(other);
+    }
+  }
+  sort(trace_list->begin(), trace_list->end(), CompareFailTime());
+}
+
+void SyntheticGenerator::GenerateClusters(vector<Meta> *meta,
+    vector<vector<FailedDisk> > *trace_lists) {
+  meta->clear();
+  trace_lists->clear();
+  trace_lists->resize(setting_.topologies.size());
+  for (size_t i = 0; i < setting_.topologies.size(); i++) {
+    Meta one_meta = setting_.topologies[i];
+    GenerateTrace(one_meta, i, &(*trace_lists)[i]);
+    one_meta.num_failures = (*trace_lists)[i].size();
+    meta->push_back(one_meta);
+  }
+}
+
+string SyntheticGenerator::GetTraceName(const Meta &meta) {
+  return "d" + to_string(meta.disks_per_node) + "n" + to_string(meta.nodes_per_rack) +
+    "r" + to_string(meta.num_racks) + ".csv";
+}
+
+// Write [dump_dir]/meta.csv and a trace per cluster [dump_dir]/d#n#r#.csv.
+bool SyntheticGenerator::Dump(const vector<Meta> &meta,
+    const vector<vector<FailedDisk> > &trace_lists) {
+  string meta_fname = setting_.dump_dir + "/meta.csv";
+  ofstream meta_file(meta_fname, ofstream::out);
+  if (meta_file.fail()) {
+    cout << "Fail to open " << meta_fname << "!" << endl;
+    return false;
+  }
+  meta_file << "#disks/node,#nodes/rack,#racks,#total disks,#failures\n";
+  for (size_t i = 0; i < meta.size(); i++) {
+    meta_file << meta[i].disks_per_node << "," << meta[i].nodes_per_rack << ",";
+    meta_file << meta[i].num_racks << "," << meta[i].total_disks << ",";
+    meta_file << meta[i].num_failures << "\n";
+    string trace_fname = setting_.dump_dir + "/" + GetTraceName(meta[i]);
+    ofstream trace_file(trace_fname, ofstream::out);
+    if (trace_file.fail()) {
+      cout << "Fail to open " << trace_fname << "!" << endl;
+      return false;
+    }
+    trace_file << "disk_total_id,fail_time\n";
+    vector<FailedDisk>::const_iterator it;
+    for (it = trace_lists[i].begin(); it < trace_lists[i].end(); it++) {
+      trace_file << it->disk_id << "," << it->fail_time << "\n";
+    }
+    trace_file.close();
+  }
+  meta_file.close();
+  return true;
+}
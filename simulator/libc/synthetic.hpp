@@ -0,0 +1,33 @@
+#ifndef SIMEDC_SYNTHETIC_HPP_
+#define SIMEDC_SYNTHETIC_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "parser.hpp"
+#include "trace.hpp"
+using namespace std;
+
+// Generates the clusters of a SyntheticSetting and a failure trace of one
+// trace period for each of them, in the formats of meta.csv and of the
+// cluster traces of the dataset. The traces only depend on the seed and the
+// index of the cluster.
+class SyntheticGenerator {
+  private:
+    SyntheticSetting setting_;
+    int seed_;
+    double period_;
+
+  public:
+    SyntheticGenerator(const SyntheticSetting &setting, int seed, double period);
+    void GenerateTrace(const Meta &meta, int cluster_idx, vector<FailedDisk> *trace_list);
+    void GenerateClusters(vector<Meta> *meta, vector<vector<FailedDisk> > *trace_lists);
+    bool Dump(const vector<Meta> &meta, const vector<vector<FailedDisk> > &trace_lists);
+    static string GetTraceName(const Meta &meta);
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "thread_pool.hpp"
+#include <unistd.h>
+
+ThreadPool::ThreadPool(int num_threads):num_pending_(0), stop_(false) {
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&task_cond_, NULL);
+  pthread_cond_init(&done_cond_, NULL);
+  if (num_threads < 1) num_threads = 1;
+  threads_.resize(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    pthread_create(&threads_[i], NULL, Worker, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  pthread_mutex_lock(&mutex_);
+  stop_ = true;
+  pthread_cond_broadcast(&task_cond_);
+  pthread_mutex_unlock(&mutex_);
+  for (size_t i = 0; i < threads_.size(); i++) {
+    pthread_join(threads_[i], NULL);
+  }
+  pthread_cond_destroy(&task_cond_);
+  pthread_cond_destroy(&done_cond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+void *ThreadPool::Worker(void *args) {
+  ThreadPool *pool = (ThreadPool *)args;
+  while (true) {
+    pthread_mutex_lock(&pool->mutex_);
+    while (pool->tasks_.empty() && !pool->stop_) {
+      pthread_cond_wait(&pool->task_cond_, &pool->mutex_);
+    }
+    if (pool->tasks_.empty()) {
+      pthread_mutex_unlock(&pool->mutex_);
+      break;
+    }
+    Task task = pool->tasks_.front();
+    pool->tasks_.pop();
+    pthread_mutex_unlock(&pool->mutex_);
+
+    task.fn(task.args);
+
+    pthread_mutex_lock(&pool->mutex_);
+    pool->num_pending_ --;
+    if (pool->num_pending_ == 0) {
+      pthread_cond_broadcast(&pool->done_cond_);
+    }
+    pthread_mutex_unlock(&pool->mutex_);
+  }
+  return 0;
+}
+
+void ThreadPool::Submit(void *(*fn)(void *), void *args) {
+  Task task = {fn, args};
+  pthread_mutex_lock(&mutex_);
+  tasks_.push(task);
+  num_pending_ ++;
+  pthread_cond_signal(&task_cond_);
+  pthread_mutex_unlock(&mutex_);
+}
+
+void ThreadPool::Wait() {
+  pthread_mutex_lock(&mutex_);
+  while (num_pending_ > 0) {
+    pthread_cond_wait(&done_cond_, &mutex_);
+  }
+  pthread_mutex_unlock(&mutex_);
+}
+
+void ThreadPool::Pin(const vector<int> &cpus, bool each) {
+  if (cpus.empty()) return;
+  for (size_t i = 0; i < threads_.size(); i++) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (each) {
+      CPU_SET(cpus[i % cpus.size()], &mask);
+    } else {
+      for (size_t j = 0; j < cpus.size(); j++) CPU_SET(cpus[j], &mask);
+    }
+    pthread_setaffinity_np(threads_[i], sizeof(mask), &mask);
+  }
+}
+
+int ThreadPool::GetNumThreads() {
+  return threads_.size();
+}
+
+int ThreadPool::GetNumCores() {
+  long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return num_cores > 0 ? (int)num_cores : 1;
+}
@@ -0,0 +1,39 @@
+#ifndef SIMEDC_THREAD_POOL_HPP_
+#define SIMEDC_THREAD_POOL_HPP_
+
+#include <pthread.h>
+#include <queue>
+#include <vector>
+using namespace std;
+
+// Fixed set of pthreads running submitted tasks. A task has the signature
+// of a pthread start routine, so functions like do_it() can be submitted
+// unchanged.
+class ThreadPool {
+  private:
+    struct Task {
+      void *(*fn)(void *);
+      void *args;
+    };
+    vector<pthread_t> threads_;
+    queue<Task> tasks_;
+    pthread_mutex_t mutex_;
+    pthread_cond_t task_cond_, done_cond_;
+    int num_pending_; // queued or running tasks
+    bool stop_;
+    static void *Worker(void *args);
+
+  public:
+    ThreadPool(int num_threads);
+    ~ThreadPool();
+    void Submit(void *(*fn)(void *), void *args);
+    // block until every submitted task has finished
+    void Wait();
+    // pin thread i to cpus[i % cpus.size()] with each, otherwise let every
+    // thread run on all of cpus; nothing for an empty list
+    void Pin(const vector<int> &cpus, bool each);
+    int GetNumThreads();
+    static int GetNumCores();
+};
+
+#endif
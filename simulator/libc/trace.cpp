@@ -48,6 +48,12 @@ void Trace::ReadTrace(vector<FailedDisk> *trace_list) {
   }
 }
 
+void Trace::Extend(vector<FailedDisk> *trace_list) {
+  if (mission_time_ > period_) {
+    Replay(trace_list);
+  }
+}
+
 void Trace::Replay(vector<FailedDisk> *trace_list) {
   int n = mission_time_ / period_;
   vector<FailedDisk> extend_trace_list;
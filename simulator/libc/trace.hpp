@@ -1,3 +1,6 @@
+#ifndef SIMEDC_TRACE_HPP_
+#define SIMEDC_TRACE_HPP_
+
 #include <assert.h>
 #include <iostream>
 #include <fstream>
@@ -23,4 +26,9 @@ class Trace {
     Trace(string fname, double mission_time);
     void ReadTrace(vector<FailedDisk> *trace_list);
     void Replay(vector<FailedDisk> *trace_list);
+    // repeat a trace of one period over the mission time
+    void Extend(vector<FailedDisk> *trace_list);
+    double GetPeriod() { return period_; }
 };
+
+#endif
@@ -2,23 +2,72 @@
 #include <cmath>
 #include <cstring>
 #include <iomanip>
+#include <set>
 #include "libc/simulation.hpp"
+#include "libc/checkpoint.hpp"
+#include "libc/result.hpp"
+#include "libc/thread_pool.hpp"
+#include "libc/analytic.hpp"
+#include "libc/synthetic.hpp"
+#include "libc/numa.hpp"
+#include "libc/prefetcher.hpp"
+#include "libc/cost_model.hpp"
+#include "libc/progress.hpp"
 
 struct Parameters {
   Configure configure;
-  vector<unsigned long> results;
+  SimStats results;
+  // common-random-numbers mode: per policy, and paired to the first policy
+  vector<SimStats> policy_results;
+  vector<PairedStats> paired_results;
+  // --affinity on several NUMA nodes: a copy of the trace on each node
+  vector<vector<FailedDisk> *> node_traces;
+};
+
+// One configuration (a config file with one combination of swept values)
+// run over the clusters of the meta file.
+struct Scenario {
+  string name;
+  Configure configure;
+  Checkpoint *checkpoint;
+  int resume_idx;
+  int idx; // cluster index as counted by this scenario
+  bool active; // whether it runs on the current cluster
+  int progress_task; // on the current cluster
+  // Markov model of the current cluster (--analytic)
+  bool has_analytic;
+  double stripe_mttdl;
+  double analytic_pdl;
+  // results of all place_type values of --bench-placement
+  string bench_fname;
+  vector<Parameters> params;
+  // --plan: fitted to the calibration runs, one per size class (log2 of
+  // the work of a cluster)
+  CostModel cost_model;
+  set<int> calibrated_classes;
+};
+
+// A scenario on a cluster, predicted by --plan.
+struct PlanTask {
+  int scenario;
+  int cluster;
+  Configure configure;
+  Meta meta;
 };
 
 void *do_it(void *args) {
   Parameters *params = (Parameters *)args;
+  // the simulation is built, and its memory first touched, by this thread
+  if (!params->node_traces.empty()) {
+    params->configure.trace_list = 
+      params->node_traces[NumaTopology::Get().GetCurrentNode()];
+  }
   Simulation simulation(&(params->configure));
-  unsigned int data_loss;
-  unsigned long tot_num_failed_stripes, tot_num_lost_chunks;
-  simulation.Run(&data_loss, &tot_num_failed_stripes, 
-      &tot_num_lost_chunks);
-  params->results.push_back((unsigned long)data_loss);
-  params->results.push_back(tot_num_failed_stripes);
-  params->results.push_back(tot_num_lost_chunks);
+  if (params->configure.crn_policies.empty()) {
+    simulation.Run(&(params->results));
+  } else {
+    simulation.RunCrn(&(params->policy_results), &(params->paired_results));
+  }
   return 0;
 }
 
@@ -32,169 +81,755 @@ void summarize_input(Configure configure) {
       configure.capacity_per_disk, configure.chunk_size, configure.num_stripes);
   printf("code_type = %s\ncode_n = %d\ncode_k = %d\n", 
       configure.code_type.c_str(), configure.code_n, configure.code_k);
+  printf("place_type = %s\n", configure.place_type.c_str());
   printf("use_failure_trace = %d\n", configure.use_failure_trace);
   printf("use_lazy_repair = %d\nlazy_repair_threshold = %d\n", 
       configure.lazy_repair, configure.lazy_repair_threshold);
+  if (!configure.crn_policies.empty()) {
+    printf("crn_policies =");
+    for (size_t p = 0; p < configure.crn_policies.size(); p++) {
+      printf(" %s", configure.crn_policies[p].name.c_str());
+    }
+    printf("\n");
+  }
   printf("network setting = [%.0f, %.0f]\n", 
       configure.network_setting[0], configure.network_setting[1]);
   printf("**************************************\n\n");
 }
 
-double calc_relative_error(int total_iterations, unsigned long tot_data_loss, 
-    double mean) {
-  vector<int> samples(total_iterations - tot_data_loss, 0);
-  vector<int> data_loss(tot_data_loss, 1);
-  samples.insert(samples.end(), data_loss.begin(), data_loss.end());
-  double sum = 0;
-  double stdev = 0;
-  for (vector<int>::iterator it = samples.begin(); it < samples.end(); it++) {
-    sum += fabs((*it - mean) * (*it - mean));
+void usage() {
+  cout << "Usage: simedc conf_file [conf_file ...] [meta_file] [--meta meta_file]" << endl;
+  cout << "              [--sweep key=v1,v2,...|key=first..last] [--threads N]" << endl;
+  cout << "              [--analytic|--analytic-only] [--bench-placement]" << endl;
+  cout << "              [--affinity none|compact|scatter] [--bench-scaling]" << endl;
+  cout << "              [--prefetch N] [--plan [--plan-iterations N]]" << endl;
+  cout << "              [--progress SECONDS] [--status-file FILE]" << endl;
+}
+
+// Append suffix to fname before its extension.
+string add_suffix(string fname, string suffix) {
+  if (fname.empty() || suffix.empty()) return fname;
+  size_t slash = fname.find_last_of('/');
+  size_t dot = fname.find_last_of('.');
+  if (dot == string::npos || (slash != string::npos && dot < slash)) {
+    return fname + suffix;
   }
-  if (total_iterations > 1) {
-    stdev = sqrt((1.0 / (total_iterations * 1.0 - 1.0)) * sum);
+  return fname.substr(0, dot) + suffix + fname.substr(dot);
+}
+
+// Trace file of a cluster, or the name of its synthetic trace.
+string get_trace_fname(const Meta &meta, bool synthetic) {
+  if (synthetic) {
+    return "synthetic:" + SyntheticGenerator::GetTraceName(meta);
   }
-  if (tot_data_loss == 0) {
-    return 0;
-  } else {
-    return (1.960 * (stdev / sqrt(total_iterations))) / mean; // 95% confidence
-    //return (1.645 * (stdev / sqrt(total_iterations))) / mean; // 90% confidence
+  return "../data/clusters/d" + to_string(meta.disks_per_node) + "n" + 
+    to_string(meta.nodes_per_rack) + ".csv";
+}
+
+// What load_traces() reads the traces of a cluster from.
+struct TraceSource {
+  const vector<Meta> *meta;
+  // generated with synthetic_topology, empty otherwise
+  const vector<vector<FailedDisk> > *synthetic_traces;
+  bool synthetic;
+  set<double> mission_times;
+};
+
+// Read the trace of a cluster once for each mission time, shared by all the
+// scenarios with that mission time.
+void load_traces(int cluster, void *args, map<double, vector<FailedDisk> > *trace_lists) {
+  TraceSource *source = (TraceSource *)args;
+  string fname = get_trace_fname((*source->meta)[cluster], source->synthetic);
+  for (set<double>::iterator it = source->mission_times.begin(); 
+      it != source->mission_times.end(); it++) {
+    vector<FailedDisk> &trace_list = (*trace_lists)[*it];
+    Trace trace(fname, *it);
+    if (!source->synthetic) {
+      trace.ReadTrace(&trace_list);
+    } else {
+      trace_list = (*source->synthetic_traces)[cluster];
+      trace.Extend(&trace_list);
+    }
+  }
+}
+
+// Clusters that a scenario will simulate, counted as in main().
+vector<int> get_scenario_clusters(const Scenario &scenario, const vector<Meta> &meta) {
+  const Configure &configure = scenario.configure;
+  vector<int> clusters;
+  int idx = scenario.idx;
+  for (size_t m = 0; m < meta.size(); m++) {
+    if (idx < configure.start_idx) {
+      idx ++;
+      continue;
+    }
+    if (idx > configure.end_idx) break;
+    if (meta[m].num_failures == 0 || meta[m].num_racks < configure.code_n) continue;
+    if (idx >= scenario.resume_idx) clusters.push_back(m);
+    idx ++;
+  }
+  return clusters;
+}
+
+// Iterations * work of all the clusters of all the scenarios, as the
+// progress reporter counts them.
+double get_sweep_work(const vector<Scenario> &scenarios, const vector<Meta> &meta,
+    bool meta_iterations) {
+  double work = 0;
+  for (vector<Scenario>::const_iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+    vector<int> clusters = get_scenario_clusters(*it, meta);
+    Configure configure = it->configure;
+    for (size_t c = 0; c < clusters.size(); c++) {
+      const Meta &one_meta = meta[clusters[c]];
+      Parser::SetCluster(&configure, one_meta);
+      if (meta_iterations) {
+        configure.num_iterations = one_meta.num_iterations / configure.num_processes + 1;
+      }
+      work += CostModel::GetWork(configure, one_meta) * configure.num_iterations * 
+        configure.num_processes;
+    }
+  }
+  return work;
+}
+
+// Clusters whose traces are read: those on which a scenario with
+// use_failure_trace is simulated.
+vector<int> get_trace_clusters(const vector<Scenario> &scenarios, const vector<Meta> &meta) {
+  vector<bool> needed(meta.size(), false);
+  for (vector<Scenario>::const_iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+    if (!it->configure.use_failure_trace) continue;
+    vector<int> clusters = get_scenario_clusters(*it, meta);
+    for (size_t c = 0; c < clusters.size(); c++) {
+      needed[clusters[c]] = true;
+    }
   }
+  vector<int> clusters;
+  for (size_t m = 0; m < meta.size(); m++) {
+    if (needed[m]) clusters.push_back(m);
+  }
+  return clusters;
+}
+
+// threads by decreasing work left
+bool has_more_work(const pair<double, Parameters *> &a, const pair<double, Parameters *> &b) {
+  return a.first > b.first;
 }
 
-void summarize_output(int total_iterations, unsigned long total_chunks,
-    unsigned long tot_data_loss, unsigned long tot_num_lost_chunks) {
-  double avg_data_loss = 1.0 * tot_data_loss / total_iterations;
-  double relative_error = calc_relative_error(total_iterations, tot_data_loss, avg_data_loss);
-  double avg_num_lost_chunks = 1.0 * tot_num_lost_chunks / total_iterations;
-  double permanent_NOMDL = avg_num_lost_chunks / total_chunks;
-  printf("PDL\t\tRE\t\tNOMDL\n");
-  printf("%.6f\t%.6f\t%e\n", avg_data_loss, relative_error, permanent_NOMDL);
+// Seconds taken by a few iterations of a scenario on this thread, writing
+// no files.
+double calibrate(Configure configure, int num_iterations) {
+  seed_seq seq = {configure.seed, 0};
+  default_random_engine generator(seq);
+  configure.generator = generator;
+  configure.thread_id = 0;
+  configure.num_processes = 1;
+  configure.num_iterations = num_iterations;
+  configure.first_iteration = 0;
+  configure.checkpoint = NULL;
+  configure.event_trace_fname = "";
+  configure.placement_dump = "";
+  Parameters params;
+  params.configure = configure;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  do_it(&params);
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Predicted seconds of each scenario on each cluster, and wall time of the
+// sweep on num_threads threads: the clusters run one after another, and the
+// threads of the scenarios of a cluster largest first.
+void print_plan(vector<Scenario> &scenarios, const vector<PlanTask> &tasks, int num_threads) {
+  for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+    it->cost_model.Fit();
+  }
+  printf("%7s %-12s %10s %12s %12s  %s\n", "cluster", "topology", "iterations", 
+      "s/iteration", "seconds", "scenario");
+  double cpu_seconds = 0, wall_seconds = 0;
+  vector<double> cluster_tasks;
+  for (size_t t = 0; t < tasks.size(); t++) {
+    const PlanTask &task = tasks[t];
+    const Configure &configure = task.configure;
+    double per_iteration = scenarios[task.scenario].cost_model.GetSecondsPerIteration(
+        configure, task.meta);
+    // of each of the num_processes threads
+    double seconds = per_iteration * configure.num_iterations;
+    string topology = "d" + to_string(configure.disks_per_node) + "n" + 
+      to_string(configure.nodes_per_rack) + "r" + to_string(configure.num_racks);
+    printf("%7d %-12s %10d %12.4f %12.1f  %s\n", task.cluster, topology.c_str(), 
+        configure.num_iterations * configure.num_processes, per_iteration, 
+        seconds * configure.num_processes, scenarios[task.scenario].name.c_str());
+    for (int i = 0; i < configure.num_processes; i++) {
+      cluster_tasks.push_back(seconds);
+    }
+    cpu_seconds += seconds * configure.num_processes;
+    if (t + 1 == tasks.size() || tasks[t + 1].cluster != task.cluster) {
+      wall_seconds += CostModel::GetMakespan(cluster_tasks, num_threads);
+      cluster_tasks.clear();
+    }
+  }
+  long wall = lround(wall_seconds);
+  printf("CPU time = %.0f s, predicted wall time on %d threads = %.0f s (%ld:%02ld:%02ld)\n",
+      cpu_seconds, num_threads, wall_seconds, wall / 3600, wall / 60 % 60, wall % 60);
+}
+
+// Merge the threads of a common-random-numbers run, write one results file
+// per policy and the paired differences to the first policy.
+void write_crn_results(Configure configure, const Meta &meta, 
+    const vector<Parameters> &params, bool header) {
+  vector<RepairPolicy> &policies = configure.crn_policies;
+  const RepairPolicy &baseline = policies[0];
+  for (size_t p = 0; p < policies.size(); p++) {
+    SimStats stats;
+    PairedStats paired;
+    for (int i = 0; i < configure.num_processes; i++) {
+      stats.Merge(params[i].policy_results[p]);
+      paired.Merge(params[i].paired_results[p]);
+    }
+    ClusterResult result = {configure.disks_per_node, configure.nodes_per_rack,
+      configure.num_racks, meta.total_disks, meta.num_failures,
+      (unsigned long)configure.num_stripes * configure.code_n, stats};
+    string suffix = "_" + policies[p].name;
+    printf("Policy: %s\n", policies[p].name.c_str());
+    PrintResult(configure.ci_method, result);
+    WriteResult(add_suffix(configure.res_fname, suffix), configure.ci_method, header, result);
+    if (!configure.stats_fname.empty()) {
+      configure.lazy_repair = policies[p].lazy_repair;
+      configure.lazy_repair_threshold = policies[p].lazy_repair_threshold;
+      WriteStats(add_suffix(configure.stats_fname, suffix), GetScenario(configure), 
+          configure.seed, result);
+    }
+    if (p > 0) {
+      PrintCrnResult(policies[p].name, baseline.name, result, paired);
+      WriteCrnResult(add_suffix(configure.res_fname, "_crn"), header && p == 1, 
+          policies[p].name, baseline.name, result, paired);
+    }
+  }
 }
 
-void summarize_output(string res_fname, int idx, int num_racks, int nodes_per_rack, 
-    int disks_per_node, int total_disks, int num_failures, int total_iterations, 
-    unsigned long total_chunks, unsigned long tot_data_loss, unsigned long tot_num_lost_chunks) {
-  double avg_data_loss = 1.0 * tot_data_loss / total_iterations;
-  double relative_error = calc_relative_error(total_iterations, tot_data_loss, avg_data_loss);
-  double avg_num_lost_chunks = 1.0 * tot_num_lost_chunks / total_iterations;
-  double permanent_NOMDL = avg_num_lost_chunks / total_chunks;
-  printf("PDL\t\tRE\t\tNOMDL\n");
-  printf("%.6f\t%.6f\t%e\n", avg_data_loss, relative_error, permanent_NOMDL);
-  ofstream outfile(res_fname, ofstream::app);
-  if (!outfile.fail()) {
-    if (idx == 0) {
-      outfile << "#disks/node,#nodes/rack,#racks,#total disks,#failures,";
-      outfile << "PDL,RE,NOMDL\n";
-    }
-    outfile << disks_per_node << "," << nodes_per_rack << "," << num_racks << ",";
-    outfile << total_disks << "," << num_failures << ",";
-    outfile << fixed << setprecision(6) << avg_data_loss << "," << relative_error << ",";
-    outfile << scientific << permanent_NOMDL << endl;
-    outfile.close();
+// Run a scenario with 1, 2, 4, ... threads and then all the cores, each
+// thread running the configured iterations, and print the iterations per
+// second and the speedup over one thread.
+void bench_scaling(const Scenario &scenario, const string &affinity,
+    const vector<vector<FailedDisk> *> &node_traces) {
+  const NumaTopology &topology = NumaTopology::Get();
+  int num_cores = ThreadPool::GetNumCores();
+  vector<int> counts;
+  for (int n = 1; n < num_cores; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(num_cores);
+  printf("Scaling benchmark: %s, affinity = %s, %d NUMA node(s)\n", scenario.name.c_str(),
+      affinity.c_str(), topology.GetNumNodes());
+  printf("%8s %10s %14s %8s %10s\n", "threads", "seconds", "iterations/s", "speedup", 
+      "efficiency");
+  double base_rate = 0;
+  for (size_t c = 0; c < counts.size(); c++) {
+    int num_threads = counts[c];
+    ThreadPool pool(num_threads);
+    pool.Pin(topology.GetThreadCpus(affinity), true);
+    vector<Parameters> params(num_threads);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < num_threads; i++) {
+      Configure configure = scenario.configure;
+      seed_seq seq = {configure.seed, i};
+      default_random_engine generator(seq);
+      configure.generator = generator;
+      configure.thread_id = i;
+      configure.num_processes = num_threads;
+      configure.first_iteration = 0;
+      configure.checkpoint = NULL;
+      configure.event_trace_fname = "";
+      params[i].configure = configure;
+      params[i].node_traces = node_traces;
+      pool.Submit(do_it, &params[i]);
+    }
+    pool.Wait();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double rate = (double)num_threads * scenario.configure.num_iterations / seconds;
+    if (c == 0) base_rate = rate;
+    printf("%8d %10.2f %14.1f %8.2f %10.2f\n", num_threads, seconds, rate, rate / base_rate,
+        rate / base_rate / num_threads);
   }
 }
+
 int main(int argc, char **argv) {
-  if (argc < 2) {
+  vector<string> conf_fnames;
+  vector<vector<SweepValue> > sweeps;
+  string meta_fname = "";
+  int num_threads = 0;
+  bool analytic = false, analytic_only = false, bench_placement = false;
+  bool bench_scaling_mode = false;
+  int prefetch_depth = 2;
+  bool plan_mode = false;
+  double progress_interval = 0;
+  string status_fname = "";
+  int plan_iterations = 2;
+  string affinity = NumaTopology::kAffinityNone;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--sweep" && i + 1 < argc) {
+      vector<SweepValue> values;
+      if (!Parser::ParseSweep(argv[++i], &values)) return 1;
+      sweeps.push_back(values);
+    } else if (arg == "--meta" && i + 1 < argc) {
+      meta_fname = argv[++i];
+    } else if (arg == "--analytic") {
+      analytic = true;
+    } else if (arg == "--analytic-only") {
+      analytic = analytic_only = true;
+    } else if (arg == "--bench-placement") {
+      bench_placement = true;
+    } else if (arg == "--bench-scaling") {
+      bench_scaling_mode = true;
+    } else if (arg == "--affinity" && i + 1 < argc) {
+      affinity = argv[++i];
+      if (!NumaTopology::IsValidAffinity(affinity)) {
+        cout << "Unknown affinity " << affinity << "!" << endl;
+        usage();
+        return 1;
+      }
+    } else if (arg == "--plan") {
+      plan_mode = true;
+    } else if (arg == "--plan-iterations" && i + 1 < argc) {
+      plan_iterations = max(1, stoi(argv[++i]));
+    } else if (arg == "--progress" && i + 1 < argc) {
+      progress_interval = stod(argv[++i]);
+    } else if (arg == "--status-file" && i + 1 < argc) {
+      status_fname = argv[++i];
+    } else if (arg == "--prefetch" && i + 1 < argc) {
+      prefetch_depth = stoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_threads = stoi(argv[++i]);
+    } else if (arg.size() > 5 && arg.compare(arg.size() - 5, 5, ".conf") == 0) {
+      conf_fnames.push_back(arg);
+    } else if (arg.compare(0, 2, "--") != 0 && !conf_fnames.empty() && meta_fname.empty()) {
+      meta_fname = arg; // simedc conf_file meta_file
+    } else {
+      usage();
+      return 0;
+    }
+  }
+  if (conf_fnames.empty()) {
     cout << "Input configure file!" << endl;
+    usage();
     return 0;
   }
-  Parser parser(argv[1]);
-  Configure configure;
-  parser.GetConfiguration(&configure);
+
+  // run every placement strategy, as the last swept parameter
+  if (bench_placement) {
+    vector<SweepValue> values;
+    for (size_t t = 0; t < PlacementStrategy::kTypes.size(); t++) {
+      SweepValue value;
+      value.label = PlacementStrategy::kTypes[t];
+      value.overrides["place_type"] = PlacementStrategy::kTypes[t];
+      values.push_back(value);
+    }
+    sweeps.push_back(values);
+  }
 
   // network setting
   double network_setting[2] = {125, 125}; // 125MB/s
   double *p_network = network_setting;
-  configure.network_setting = p_network;
 
-  pthread_t *thread;
-  thread = new pthread_t[configure.num_processes];
-  Parameters *params;
-  params = new Parameters[configure.num_processes];
+  // cartesian product of the swept values
+  vector<SweepValue> combinations(1);
+  for (vector<vector<SweepValue> >::iterator it_sweep = sweeps.begin(); 
+      it_sweep < sweeps.end(); it_sweep++) {
+    vector<SweepValue> extended;
+    for (vector<SweepValue>::iterator it = combinations.begin(); it < combinations.end(); it++) {
+      for (vector<SweepValue>::iterator it_value = it_sweep->begin(); 
+          it_value < it_sweep->end(); it_value++) {
+        SweepValue value = *it;
+        value.label += "_" + it_value->label;
+        for (map<string, string>::iterator it_key = it_value->overrides.begin();
+            it_key != it_value->overrides.end(); it_key++) {
+          value.overrides[it_key->first] = it_key->second;
+        }
+        extended.push_back(value);
+      }
+    }
+    combinations = extended;
+  }
 
-  // read meta file
-  int idx = 0;
+  vector<Scenario> scenarios;
+  int max_processes = 1;
+  for (vector<string>::iterator it_conf = conf_fnames.begin(); 
+      it_conf < conf_fnames.end(); it_conf++) {
+    Parser parser(*it_conf);
+    for (vector<SweepValue>::iterator it = combinations.begin(); it < combinations.end(); it++) {
+      Scenario scenario;
+      scenario.name = *it_conf + it->label;
+      Configure &configure = scenario.configure;
+      parser.GetConfiguration(&configure, it->overrides);
+      configure.network_setting = p_network;
+      if (bench_placement) {
+        string label = it->label.substr(0, it->label.size() - configure.place_type.size() - 1);
+        scenario.bench_fname = add_suffix(configure.res_fname, label + "_placement");
+      }
+      // each scenario writes its own files
+      configure.res_fname = add_suffix(configure.res_fname, it->label);
+      configure.stats_fname = add_suffix(configure.stats_fname, it->label);
+      configure.histogram_fname = add_suffix(configure.histogram_fname, it->label);
+      configure.foreground.fname = add_suffix(configure.foreground.fname, it->label);
+      configure.checkpoint_fname = add_suffix(configure.checkpoint_fname, it->label);
+      configure.event_trace_fname = add_suffix(configure.event_trace_fname, it->label);
+
+      if (!configure.crn_policies.empty() && !configure.checkpoint_fname.empty()) {
+        cout << scenario.name << ": checkpoints are not supported with crn_policies, ignored" << endl;
+        configure.checkpoint_fname = "";
+      }
+      if (!configure.crn_policies.empty() && !configure.histogram_fname.empty()) {
+        cout << scenario.name << ": histograms are not supported with crn_policies, ignored" << endl;
+        configure.histogram_fname = "";
+      }
+      if (!configure.crn_policies.empty() && configure.foreground.read_rate > 0) {
+        cout << scenario.name << ": read_rate is not supported with crn_policies, ignored" << endl;
+        configure.foreground.read_rate = 0;
+      }
+      // resume from the checkpoint if it was taken with the same configuration
+      scenario.checkpoint = NULL;
+      scenario.resume_idx = 0;
+      if (!configure.checkpoint_fname.empty()) {
+        scenario.checkpoint = new Checkpoint(configure.checkpoint_fname, 
+            Checkpoint::GetFingerprint(configure));
+        vector<string> outputs = {configure.res_fname, configure.stats_fname, 
+          configure.histogram_fname, configure.foreground.fname};
+        scenario.checkpoint->SetOutputs(outputs);
+        if (scenario.checkpoint->LoadProgress(&scenario.resume_idx)) {
+          printf("%s: resume from cluster %d\n", scenario.name.c_str(), scenario.resume_idx);
+        } else {
+          scenario.resume_idx = 0;
+          scenario.checkpoint->SaveProgress(scenario.resume_idx);
+        }
+      }
+      configure.checkpoint = scenario.checkpoint;
+      scenario.idx = 0;
+      scenario.has_analytic = false;
+      scenario.params.resize(configure.num_processes);
+      max_processes = max(max_processes, configure.num_processes);
+      scenarios.push_back(scenario);
+    }
+  }
+  if (num_threads <= 0) {
+    num_threads = scenarios.size() > 1 ? ThreadPool::GetNumCores() : max_processes;
+  }
+  // before any thread is created, see ProgressReporter()
+  ProgressReporter progress(progress_interval, status_fname, num_threads);
+  ThreadPool pool(num_threads);
+  const NumaTopology &topology = NumaTopology::Get();
+  // several nodes: each node gets its own copy of the traces
+  bool replicate = affinity != NumaTopology::kAffinityNone && topology.GetNumNodes() > 1;
+  if (affinity != NumaTopology::kAffinityNone) {
+    pool.Pin(topology.GetThreadCpus(affinity), true);
+    printf("affinity = %s, %d threads on %d NUMA node(s)\n", affinity.c_str(), num_threads,
+        topology.GetNumNodes());
+  }
+
+  // read meta file, or generate the clusters with synthetic_topology
+  Parser parser(conf_fnames[0]);
   vector<Meta> meta;
-  if (argc < 3) {
+  const SyntheticSetting &synthetic = scenarios[0].configure.synthetic;
+  vector<vector<FailedDisk> > synthetic_traces;
+  if (!synthetic.topologies.empty()) {
+    SyntheticGenerator generator(synthetic, scenarios[0].configure.seed, 
+        Trace("", 0).GetPeriod());
+    generator.GenerateClusters(&meta, &synthetic_traces);
+    if (!synthetic.dump_dir.empty()) {
+      generator.Dump(meta, synthetic_traces);
+    }
+  } else if (meta_fname.empty()) {
     parser.GetMeta(&meta);
   } else {
-    string meta_fname = argv[2];
     parser.GetMeta(&meta, meta_fname);
   }
+  progress.SetTotalWork(get_sweep_work(scenarios, meta, !meta_fname.empty()));
+  // read the traces of the next clusters while the current one is simulated
+  TraceSource trace_source = {&meta, &synthetic_traces, !synthetic.topologies.empty(), 
+    set<double>()};
+  for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+    if (it->configure.use_failure_trace) {
+      trace_source.mission_times.insert(it->configure.mission_time);
+    }
+  }
+  TracePrefetcher *prefetcher = NULL;
+  vector<PlanTask> plan_tasks;
+  if (prefetch_depth > 0 && !analytic_only && !trace_source.mission_times.empty()) {
+    prefetcher = new TracePrefetcher(get_trace_clusters(scenarios, meta), prefetch_depth,
+        load_traces, &trace_source);
+  }
   for (vector<Meta>::iterator it_meta = meta.begin(); it_meta < meta.end(); it_meta++) {
-    if (idx < configure.start_idx) {
-      idx ++;
-      continue;
+    // decide which scenarios run on this cluster
+    bool any_active = false, all_done = true;
+    for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+      Configure &configure = it->configure;
+      it->active = false;
+      if (it->idx < configure.start_idx) {
+        it->idx ++;
+        all_done = false;
+        continue;
+      }
+      if (it->idx > configure.end_idx) {
+        continue;
+      }
+      all_done = false;
+      Parser::SetCluster(&configure, *it_meta);
+      if (it_meta->num_failures == 0) {
+        continue;
+      }
+      if (it_meta->num_racks < configure.code_n) {
+        continue;
+      }
+      if (!meta_fname.empty()) {
+        configure.num_iterations = it_meta->num_iterations / configure.num_processes + 1;
+      }
+      // results of the clusters before resume_idx are already in res_fname
+      if (it->idx < it->resume_idx) {
+        it->idx ++;
+        continue;
+      }
+      configure.cluster_idx = it->idx;
+      it->active = true;
+      any_active = true;
     }
-    if (idx > configure.end_idx) {
+    if (all_done) {
       break;
     }
-    configure.num_racks = it_meta->num_racks;
-    configure.nodes_per_rack = it_meta->nodes_per_rack;
-    configure.disks_per_node = it_meta->disks_per_node;
-    int num_disks = configure.num_racks * configure.nodes_per_rack * configure.disks_per_node;
-    configure.num_stripes = configure.capacity_per_disk * num_disks / configure.code_n / configure.chunk_size / 2;
-    if (it_meta->num_failures == 0) {
+    if (!any_active) {
       continue;
     }
-    if (it_meta->num_racks < configure.code_n) {
-      continue;
+
+    // solve the Markov model of each scenario, in place of the simulation 
+    // with --analytic-only
+    for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+      if (!it->active || !analytic) continue;
+      Configure &configure = it->configure;
+      string reason;
+      it->has_analytic = AnalyticModel::IsSupported(configure, &reason);
+      if (!it->has_analytic) {
+        cout << it->name << ": no analytic model with " << reason << endl;
+        continue;
+      }
+      AnalyticModel model(configure);
+      it->stripe_mttdl = model.GetStripeMttdl();
+      it->analytic_pdl = model.GetPdl();
+      if (analytic_only) {
+        ClusterResult result = {configure.disks_per_node, configure.nodes_per_rack,
+          configure.num_racks, it_meta->total_disks, it_meta->num_failures,
+          (unsigned long)configure.num_stripes * configure.code_n, SimStats(),
+          true, it->analytic_pdl};
+        printf("%s: d%dn%d, stripe MTTDL = %e hours, PDL (analytic) = %e\n", 
+            it->name.c_str(), configure.disks_per_node, configure.nodes_per_rack,
+            it->stripe_mttdl, it->analytic_pdl);
+        WriteAnalyticResult(add_suffix(configure.res_fname, "_analytic"), it->idx == 0, 
+            result, it->stripe_mttdl);
+      }
     }
-    if (argc == 3) {
-      configure.num_iterations = it_meta->num_iterations / configure.num_processes + 1;
+    if (analytic_only) {
+      for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+        if (it->active) it->idx ++;
+      }
+      continue;
     }
-    char tracefname[80] = "../data/clusters/d";
-    strcat(tracefname, to_string(configure.disks_per_node).c_str());
-    strcat(tracefname, string("n").c_str());
-    strcat(tracefname, to_string(configure.nodes_per_rack).c_str());
-    strcat(tracefname, string(".csv").c_str());
+
+    string tracefname = get_trace_fname(*it_meta, trace_source.synthetic);
     cout << tracefname << endl;
-    configure.trace_fname = string(tracefname);
 
-    // read trace
-    vector<FailedDisk> trace_list;
-    if (configure.use_failure_trace) {
-      Trace trace(configure.trace_fname, configure.mission_time);
-      trace.ReadTrace(&trace_list);
+    // taken from the prefetcher, or read now without it
+    map<double, vector<FailedDisk> > trace_lists;
+    int cluster = it_meta - meta.begin();
+    if (prefetcher == NULL || !prefetcher->Get(cluster, &trace_lists)) {
+      TraceSource source = trace_source;
+      source.mission_times.clear();
+      for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+        if (it->active && it->configure.use_failure_trace) {
+          source.mission_times.insert(it->configure.mission_time);
+        }
+      }
+      load_traces(cluster, &source, &trace_lists);
+    }
+    for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+      if (!it->active) continue;
+      Configure &configure = it->configure;
+      configure.trace_fname = tracefname;
+      configure.trace_list = &trace_lists[configure.mission_time];
+    }
+    // copied by this thread while it runs on the node, so that the pages of
+    // each copy are allocated there
+    map<double, vector<vector<FailedDisk> > > node_trace_lists;
+    if (replicate) {
+      map<double, vector<FailedDisk> >::iterator it_trace;
+      for (it_trace = trace_lists.begin(); it_trace != trace_lists.end(); it_trace++) {
+        vector<vector<FailedDisk> > &copies = node_trace_lists[it_trace->first];
+        copies.resize(topology.GetNumNodes());
+        for (int node = 0; node < topology.GetNumNodes(); node++) {
+          cpu_set_t previous;
+          NumaTopology::PinCurrentThread(topology.GetNodeCpus(node), &previous);
+          copies[node] = it_trace->second;
+          NumaTopology::RestoreCurrentThread(previous);
+        }
+      }
+    }
+
+    if (bench_scaling_mode) {
+      for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+        if (!it->active) continue;
+        vector<vector<FailedDisk> *> node_traces;
+        for (int node = 0; replicate && node < topology.GetNumNodes(); node++) {
+          node_traces.push_back(&node_trace_lists[it->configure.mission_time][node]);
+        }
+        bench_scaling(*it, affinity, node_traces);
+        it->idx ++;
+      }
+      continue;
     }
-    configure.trace_list = &trace_list;
 
-    summarize_input(configure);
+    // calibrate each scenario on the first cluster of each size class
+    if (plan_mode) {
+      for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+        if (!it->active) continue;
+        Configure &configure = it->configure;
+        double work = CostModel::GetWork(configure, *it_meta);
+        if (it->calibrated_classes.insert((int)log2(max(work, 1.0))).second) {
+          double seconds = calibrate(configure, plan_iterations);
+          it->cost_model.AddSample(configure, *it_meta, seconds / plan_iterations);
+          printf("%s: calibrated on d%dn%dr%d, %.4f s/iteration\n", it->name.c_str(),
+              configure.disks_per_node, configure.nodes_per_rack, configure.num_racks,
+              seconds / plan_iterations);
+        }
+        PlanTask task = {(int)(it - scenarios.begin()), (int)(it_meta - meta.begin()), 
+          configure, *it_meta};
+        plan_tasks.push_back(task);
+        it->idx ++;
+      }
+      continue;
+    }
 
-    // note that rand() is not a thread-safe function
-    // when using multiple-threads, the results are not reproduced.
-    srand(configure.seed); 
+    // threads left with the most work first, so that the cluster does not
+    // end on a long thread started last
+    vector<pair<double, Parameters *> > submissions;
+    for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+      if (!it->active) continue;
+      Configure &configure = it->configure;
+      if (scenarios.size() > 1) {
+        printf("Scenario: %s\n", it->name.c_str());
+      }
+      summarize_input(configure);
+      double work = CostModel::GetWork(configure, *it_meta);
+      it->progress_task = progress.AddTask(it->name, it_meta - meta.begin(), 
+          configure.num_processes, (long)configure.num_iterations * configure.num_processes,
+          work);
 
+      for (int i = 0; i < configure.num_processes; i++) {
+        // derive a distinct stream for each (seed, thread); seeding with
+        // seed + i * 1000 made seed 0 and 1 equal and overlapped other seeds
+        seed_seq seq = {configure.seed, i};
+        default_random_engine generator(seq);
+        configure.generator = generator;
+        configure.thread_id = i;
+        Parameters &params = it->params[i];
+        params.configure = configure;
+        params.configure.progress = &progress;
+        params.configure.progress_task = it->progress_task;
+        params.node_traces.clear();
+        for (int node = 0; replicate && node < topology.GetNumNodes(); node++) {
+          params.node_traces.push_back(&node_trace_lists[configure.mission_time][node]);
+        }
+        if (!configure.event_trace_fname.empty()) {
+          params.configure.event_trace_fname += ".c" + to_string(it->idx);
+        }
+        params.results = SimStats();
+        params.configure.first_iteration = 0;
+        ThreadState thread_state;
+        if (it->checkpoint != NULL && it->checkpoint->LoadThread(i, &thread_state) && 
+            thread_state.cluster_idx == it->idx) {
+          params.configure.generator = thread_state.generator;
+          params.configure.first_iteration = thread_state.iterations_done;
+          params.results = thread_state.stats;
+          printf("%s: thread %d resumes at iteration %d\n", it->name.c_str(), i, 
+              thread_state.iterations_done);
+        }
+        int iterations_left = configure.num_iterations - params.configure.first_iteration;
+        submissions.push_back(make_pair(work * iterations_left, &params));
+      }
+    }
+    stable_sort(submissions.begin(), submissions.end(), has_more_work);
+    for (size_t s = 0; s < submissions.size(); s++) {
+      pool.Submit(do_it, submissions[s].second);
+    }
+    pool.Wait();
 
-    //vector<future<vector<unsigned long>> > fut;
-    for (int i = 0; i < configure.num_processes; i++) {
-      // change rseed for each thread when multi-threading
-      default_random_engine generator(configure.seed + i * 1000); 
-      configure.generator = generator;
-      params[i].configure = configure;
-      vector<unsigned long> results;
-      params[i].results = results;
-      pthread_create(&thread[i], NULL, do_it, &params[i]);
-      //fut.push_back(async(do_it, configure));
+    for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+      if (!it->active) continue;
+      progress.FinishTask(it->progress_task);
+      Configure &configure = it->configure;
+      if (!configure.crn_policies.empty()) {
+        if (scenarios.size() > 1) {
+          printf("Scenario: %s\n", it->name.c_str());
+        }
+        write_crn_results(configure, *it_meta, it->params, it->idx == 0);
+        it->idx ++;
+        continue;
+      }
+      SimStats stats;
+      for (int i = 0; i < configure.num_processes; i++) {
+        stats.Merge(it->params[i].results);
+      }
+      ClusterResult result = {configure.disks_per_node, configure.nodes_per_rack,
+        configure.num_racks, it_meta->total_disks, it_meta->num_failures,
+        (unsigned long)configure.num_stripes * configure.code_n, stats,
+        it->has_analytic, it->analytic_pdl};
+      if (scenarios.size() > 1) {
+        printf("Scenario: %s\n", it->name.c_str());
+      }
+      PrintResult(configure.ci_method, result);
+      WriteResult(configure.res_fname, configure.ci_method, it->idx == 0, result);
+      if (configure.foreground.read_rate > 0) {
+        PrintForeground(result);
+        if (!configure.foreground.fname.empty()) {
+          WriteForeground(configure.foreground.fname, it->idx == 0, configure.mission_time,
+              configure.foreground.num_bins, result);
+        }
+      }
+      if (!configure.stats_fname.empty()) {
+        WriteStats(configure.stats_fname, GetScenario(configure), configure.seed, result);
+      }
+      if (!configure.histogram_fname.empty()) {
+        WriteHistograms(configure.histogram_fname, it->idx == 0, result);
+      }
+      if (bench_placement) {
+        WritePlacementBench(it->bench_fname, configure.place_type, configure.ci_method,
+            it->idx == 0 && configure.place_type == PlacementStrategy::kTypes[0], result);
+      }
+      if (it->checkpoint != NULL) {
+        it->checkpoint->SaveProgress(it->idx + 1);
+      }
+      it->idx ++;
     }
-    unsigned long tot_data_loss = 0, tot_num_failed_stripes = 0, tot_num_lost_chunks = 0;
-    for (int i = 0; i < configure.num_processes; i++) {
-      //vector<unsigned long> results = fut[i].get();
-      pthread_join(thread[i], NULL);
-      tot_data_loss += params[i].results[0];
-      tot_num_failed_stripes += params[i].results[1];
-      tot_num_lost_chunks += params[i].results[2];
-    }
-    int total_iterations = configure.num_processes * configure.num_iterations;
-    unsigned long total_chunks = configure.num_stripes * configure.code_n;
-    summarize_output(configure.res_fname, idx, configure.num_racks,
-        configure.nodes_per_rack, configure.disks_per_node, 
-        it_meta->total_disks, it_meta->num_failures, total_iterations, 
-        total_chunks, tot_data_loss, tot_num_lost_chunks);
-    idx ++;
+    if (bench_placement) {
+      printf("Placement benchmark: %s\n", tracefname.c_str());
+      printf("%-10s %12s %10s %-20s %s\n", "place_type", "ms/iteration", "PDL", 
+          "PDL 95% CI", "NOMDL");
+      for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+        if (!it->active || !it->configure.crn_policies.empty()) continue;
+        Configure &configure = it->configure;
+        SimStats stats;
+        for (int i = 0; i < configure.num_processes; i++) {
+          stats.Merge(it->params[i].results);
+        }
+        ClusterResult result = {configure.disks_per_node, configure.nodes_per_rack,
+          configure.num_racks, it_meta->total_disks, it_meta->num_failures,
+          (unsigned long)configure.num_stripes * configure.code_n, stats, false, 0.0};
+        PrintPlacementBench(configure.place_type, configure.ci_method, result);
+      }
+    }
+  }
+  delete prefetcher;
+  if (plan_mode) {
+    print_plan(scenarios, plan_tasks, num_threads);
+  }
+  for (vector<Scenario>::iterator it = scenarios.begin(); it < scenarios.end(); it++) {
+    delete it->checkpoint;
   }
-  delete [] thread;
-  delete [] params;
 
   return 0;
 }
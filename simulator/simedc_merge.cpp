@@ -0,0 +1,74 @@
+#include <cstring>
+#include <map>
+#include <set>
+#include "libc/result.hpp"
+
+// Combine the stats files of several shards of the same scenario into one
+// results CSV. Shards must be run with different seeds.
+
+string get_cluster_key(const ClusterResult &result) {
+  stringstream s;
+  s << result.disks_per_node << "," << result.nodes_per_rack << "," << result.num_racks;
+  s << "," << result.total_disks << "," << result.num_failures << "," << result.total_chunks;
+  return s.str();
+}
+
+int main(int argc, char **argv) {
+  string ci_method = "wilson";
+  int arg_idx = 1;
+  if (argc > 2 && strcmp(argv[1], "-c") == 0) {
+    ci_method = argv[2];
+    arg_idx = 3;
+  }
+  if (argc - arg_idx < 2) {
+    cout << "Usage: simedc-merge [-c wilson|clopper-pearson] res_fname stats_file..." << endl;
+    return 0;
+  }
+  string res_fname = argv[arg_idx++];
+
+  string scenario = "";
+  set<int> seeds;
+  vector<string> keys; // clusters in order of first appearance
+  map<string, ClusterResult> merged;
+  for (; arg_idx < argc; arg_idx++) {
+    string shard_scenario;
+    int seed = 0;
+    vector<ClusterResult> results;
+    if (!ReadStats(argv[arg_idx], &shard_scenario, &seed, &results)) {
+      return 1;
+    }
+    if (scenario.empty()) {
+      scenario = shard_scenario;
+    } else if (shard_scenario != scenario) {
+      cout << argv[arg_idx] << " has a different scenario (" << shard_scenario;
+      cout << ") from the other shards (" << scenario << ")!" << endl;
+      return 1;
+    }
+    if (!seeds.insert(seed).second) {
+      cout << "Warning: seed " << seed << " of " << argv[arg_idx];
+      cout << " is used by another shard, the samples are not independent!" << endl;
+    }
+    for (vector<ClusterResult>::iterator it = results.begin(); it < results.end(); it++) {
+      string key = get_cluster_key(*it);
+      map<string, ClusterResult>::iterator it_merged = merged.find(key);
+      if (it_merged == merged.end()) {
+        merged[key] = *it;
+        keys.push_back(key);
+      } else {
+        it_merged->second.stats.Merge(it->stats);
+      }
+    }
+  }
+
+  cout << "scenario: " << scenario << ", shards: " << seeds.size() << endl;
+  for (vector<string>::iterator it = keys.begin(); it < keys.end(); it++) {
+    ClusterResult &result = merged[*it];
+    SimStats &stats = result.stats;
+    stats.lost_chunks = RunningStats::FromSums(stats.data_loss.GetTrials(),
+        (double)stats.sum_lost_chunks, (double)stats.sum_sq_lost_chunks);
+    cout << *it << ": iterations = " << stats.data_loss.GetTrials() << endl;
+    PrintResult(ci_method, result);
+    WriteResult(res_fname, ci_method, it == keys.begin(), result);
+  }
+  return 0;
+}
@@ -0,0 +1,86 @@
+#!/bin/sh
+# Kill a checkpointed run in the middle of a cluster, resume it, and check
+# that the results are those of an uninterrupted run.
+# usage: tests/checkpoint_resume.sh [simedc binary]
+BIN=$(cd "$(dirname "${1:-./simedc}")" && pwd)/$(basename "${1:-./simedc}")
+DIR=$(mktemp -d)
+trap 'rm -rf $DIR' EXIT
+cd $DIR
+
+cat > test.conf <<CONF
+processes=2
+iterations=200
+mission=87600
+chunk_size=256
+code_type=Rep
+code_n=2
+code_k=1
+code_l=0
+failure_trace=1
+lazy_repair=0
+lazy_th=2
+seed=7
+res_fname=$DIR/res.csv
+histogram_fname=$DIR/hist.csv
+read_rate=0.01
+foreground_fname=$DIR/reads.csv
+start_idx=0
+end_idx=3
+synthetic_topology=2x4x16,2x4x20,4x4x16
+synthetic_afr=1
+synthetic_burst_prob=0.2
+synthetic_burst_size=10
+synthetic_burst_scope=rack
+CONF
+
+$BIN test.conf > reference.log 2>&1 || { echo "FAIL: reference run"; exit 1; }
+mv res.csv reference.csv
+mv hist.csv reference_hist.csv
+mv reads.csv reference_reads.csv
+
+printf "checkpoint_fname=$DIR/run.ckpt\ncheckpoint_interval=10\n" >> test.conf
+$BIN test.conf > killed.log 2>&1 &
+PID=$!
+# kill once a thread has saved the middle of a cluster
+while kill -0 $PID 2>/dev/null; do
+  if [ -f run.ckpt.t0 ] && [ "$(sed -n 3p run.ckpt.t0 | cut -d' ' -f2)" -gt 0 ] 2>/dev/null; then
+    kill -9 $PID
+    break
+  fi
+done
+wait $PID 2>/dev/null
+$BIN test.conf > resumed.log 2>&1 || { echo "FAIL: resumed run"; exit 1; }
+
+if ! grep -q "resumes at iteration" resumed.log; then
+  echo "FAIL: no thread resumed from its checkpoint"
+  cat resumed.log
+  exit 1
+fi
+if ! diff reference.csv res.csv || ! diff reference_hist.csv hist.csv ||
+    ! diff reference_reads.csv reads.csv; then
+  echo "FAIL: resumed results differ from the uninterrupted run"
+  exit 1
+fi
+
+# a crash after the rows of the last cluster were written, but before the
+# checkpoint recorded them: the rows are cut off and the cluster runs again
+RES_SIZE=$(head -n 3 reference.csv | wc -c)
+HIST_SIZE=$(grep -v "^4,4,16," reference_hist.csv | wc -c)
+READS_SIZE=$(grep -v "^4,4,16," reference_reads.csv | wc -c)
+awk -v res=$RES_SIZE -v hist=$HIST_SIZE -v reads=$READS_SIZE '
+  NR == 3 { print 2; next }
+  /res.csv$/ { print res, $2; next }
+  /hist.csv$/ { print hist, $2; next }
+  /reads.csv$/ { print reads, $2; next }
+  { print }' run.ckpt > run.ckpt.new && mv run.ckpt.new run.ckpt
+$BIN test.conf > rerun.log 2>&1 || { echo "FAIL: run after the crash"; exit 1; }
+if ! grep -q "resume from cluster 2" rerun.log; then
+  echo "FAIL: the last cluster did not run again"
+  exit 1
+fi
+if ! diff reference.csv res.csv || ! diff reference_hist.csv hist.csv ||
+    ! diff reference_reads.csv reads.csv; then
+  echo "FAIL: rows written before the crash are repeated"
+  exit 1
+fi
+echo "PASS: checkpoint_resume"
@@ -0,0 +1,47 @@
+#!/bin/sh
+# Run eager repair on failure traces with bursts of failures at the same time,
+# with and without danger_filter, and check that the results are identical:
+# the filter drops the failures of most busy periods, which must not change
+# the order of the events of the others.
+# usage: tests/danger_filter.sh [simedc binary]
+BIN=$(cd "$(dirname "${1:-./simedc}")" && pwd)/$(basename "${1:-./simedc}")
+DIR=$(mktemp -d)
+trap 'rm -rf $DIR' EXIT
+cd $DIR
+
+for code in "RSC 9 6 0 0.5" "LRC 16 12 2 0.5" "Rep 3 1 0 1"; do
+  set -- $code
+  for filter in 0 1; do
+    cat > $1_$filter.conf <<CONF
+processes=2
+iterations=40
+mission=87600
+chunk_size=256
+code_type=$1
+code_n=$2
+code_k=$3
+code_l=$4
+failure_trace=1
+lazy_repair=0
+lazy_th=2
+seed=3
+danger_filter=$filter
+res_fname=$DIR/$1_$filter.csv
+start_idx=0
+end_idx=1
+synthetic_topology=8x8x16
+synthetic_afr=$5
+synthetic_burst_prob=0.3
+synthetic_burst_size=20
+synthetic_burst_scope=node
+synthetic_burst_window=0
+CONF
+    $BIN $1_$filter.conf > $1_$filter.log 2>&1 || { echo "FAIL: $1 run"; exit 1; }
+  done
+  if ! diff $1_0.csv $1_1.csv; then
+    echo "FAIL: $1 results change with danger_filter"
+    exit 1
+  fi
+done
+
+echo "PASS: danger_filter"